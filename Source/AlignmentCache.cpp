@@ -0,0 +1,134 @@
+#include "AlignmentCache.h"
+#include "AtomicFileWriter.h"
+
+namespace {
+constexpr int fileMagic = 0x41524946; // "FIRA"
+constexpr int fileVersion = 1;
+} // namespace
+
+size_t AlignmentCache::KeyHasher::operator()(const Key &k) const {
+  uint64_t h = k.refHash * 31 + k.targetHash;
+  h = h * 31 + k.settingsHash;
+  h = h * 31 + (uint64_t)k.refRate;
+  h = h * 31 + (uint64_t)k.targetRate;
+  return (size_t)h;
+}
+
+AlignmentCache::AlignmentCache(int maxEntriesToKeep)
+    : maxEntries(juce::jmax(1, maxEntriesToKeep)) {}
+
+void AlignmentCache::setFile(const juce::File &file) {
+  const juce::ScopedLock sl(lock);
+  if (file != cacheFile) {
+    cacheFile = file;
+    loaded = false;
+  }
+}
+
+bool AlignmentCache::lookup(const Key &key, Entry &result) {
+  const juce::ScopedLock sl(lock);
+  loadIfNeeded();
+
+  if (lookupExact(key, result))
+    return true;
+
+  if (lookupExact(key.swapped(), result)) {
+    result.lagMs = -result.lagMs;
+    return true;
+  }
+  return false;
+}
+
+void AlignmentCache::store(const Key &key, const Entry &entry) {
+  const juce::ScopedLock sl(lock);
+  loadIfNeeded();
+  insert(key, entry);
+  dirty = true;
+}
+
+bool AlignmentCache::lookupExact(const Key &key, Entry &result) {
+  auto found = index.find(key);
+  if (found == index.end())
+    return false;
+
+  // Touch: move to the front of the LRU list
+  items.splice(items.begin(), items, found->second);
+  result = found->second->second;
+  return true;
+}
+
+void AlignmentCache::insert(const Key &key, const Entry &entry) {
+  auto found = index.find(key);
+  if (found != index.end()) {
+    found->second->second = entry;
+    items.splice(items.begin(), items, found->second);
+    return;
+  }
+
+  items.emplace_front(key, entry);
+  index[key] = items.begin();
+
+  while ((int)items.size() > maxEntries) {
+    index.erase(items.back().first);
+    items.pop_back();
+  }
+}
+
+//==============================================================================
+void AlignmentCache::loadIfNeeded() {
+  if (loaded)
+    return;
+  loaded = true;
+
+  if (!cacheFile.existsAsFile())
+    return;
+
+  juce::FileInputStream in(cacheFile);
+  if (!in.openedOk() || in.readInt() != fileMagic ||
+      in.readInt() != fileVersion)
+    return;
+
+  // Stored most recent first; append so the order survives the round trip
+  int count = juce::jmin(in.readInt(), maxEntries);
+  for (int i = 0; i < count && !in.isExhausted(); ++i) {
+    Key key;
+    key.refHash = (uint64_t)in.readInt64();
+    key.targetHash = (uint64_t)in.readInt64();
+    key.settingsHash = (uint64_t)in.readInt64();
+    key.refRate = in.readDouble();
+    key.targetRate = in.readDouble();
+
+    Entry entry;
+    entry.lagMs = in.readDouble();
+    entry.strength = in.readDouble();
+
+    if (index.find(key) == index.end()) {
+      items.emplace_back(key, entry);
+      index[key] = std::prev(items.end());
+    }
+  }
+}
+
+void AlignmentCache::save() {
+  const juce::ScopedLock sl(lock);
+  if (!dirty || cacheFile == juce::File())
+    return;
+
+  auto writeEntries = [this](juce::OutputStream &out) {
+    out.writeInt(fileMagic);
+    out.writeInt(fileVersion);
+    out.writeInt((int)items.size());
+    for (const auto &[key, entry] : items) {
+      out.writeInt64((juce::int64)key.refHash);
+      out.writeInt64((juce::int64)key.targetHash);
+      out.writeInt64((juce::int64)key.settingsHash);
+      out.writeDouble(key.refRate);
+      out.writeDouble(key.targetRate);
+      out.writeDouble(entry.lagMs);
+      out.writeDouble(entry.strength);
+    }
+  };
+
+  if (AtomicFileWriter::write(cacheFile, writeEntries))
+    dirty = false;
+}
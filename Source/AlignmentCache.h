@@ -0,0 +1,75 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <list>
+#include <unordered_map>
+
+//==============================================================================
+// AlignmentCache: remembers pairwise alignment results across presses of
+// Auto Align and across sessions.
+//
+// Entries are keyed by the content hashes of both IRs, their sample rates
+// and a hash of the analysis settings, so browsing back to a known pair (or
+// loading a preset) skips the correlation entirely. The cache is an LRU of
+// bounded size, kept in memory and mirrored to a small binary file next to
+// the global settings. Thread-safe; lookups come from the aligner's pool.
+//==============================================================================
+class AlignmentCache {
+public:
+  struct Key {
+    uint64_t refHash = 0, targetHash = 0, settingsHash = 0;
+    double refRate = 0.0, targetRate = 0.0;
+
+    bool operator==(const Key &o) const {
+      return refHash == o.refHash && targetHash == o.targetHash &&
+             settingsHash == o.settingsHash && refRate == o.refRate &&
+             targetRate == o.targetRate;
+    }
+
+    // Same pair seen from the other side
+    Key swapped() const {
+      return {targetHash, refHash, settingsHash, targetRate, refRate};
+    }
+  };
+
+  struct Entry {
+    double lagMs = 0.0;
+    double strength = 0.0;
+  };
+
+  static constexpr int defaultMaxEntries = 2048;
+
+  explicit AlignmentCache(int maxEntries = defaultMaxEntries);
+
+  // Where the cache persists; loaded lazily on first use
+  void setFile(const juce::File &file);
+
+  // Also answers for the swapped pair, with the lag negated
+  bool lookup(const Key &key, Entry &result);
+  void store(const Key &key, const Entry &entry);
+
+  // Writes the file if anything changed since the last save
+  void save();
+
+private:
+  struct KeyHasher {
+    size_t operator()(const Key &k) const;
+  };
+
+  using Item = std::pair<Key, Entry>;
+
+  bool lookupExact(const Key &key, Entry &result);
+  void insert(const Key &key, const Entry &entry);
+  void loadIfNeeded();
+
+  juce::CriticalSection lock;
+  std::list<Item> items; // Most recently used first
+  std::unordered_map<Key, std::list<Item>::iterator, KeyHasher> index;
+  int maxEntries;
+
+  juce::File cacheFile;
+  bool loaded = false;
+  bool dirty = false;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AlignmentCache)
+};
@@ -0,0 +1,19 @@
+#include "AtomicFileWriter.h"
+
+bool AtomicFileWriter::write(
+    const juce::File &target,
+    const std::function<void(juce::OutputStream &)> &writeContent) {
+  juce::TemporaryFile temp(target);
+  {
+    juce::FileOutputStream out(temp.getFile());
+    if (!out.openedOk())
+      return false;
+
+    writeContent(out);
+    out.flush();
+    if (out.getStatus().failed())
+      return false;
+  }
+
+  return temp.overwriteTargetFileWithTemporary();
+}
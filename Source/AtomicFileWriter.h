@@ -0,0 +1,14 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// AtomicFileWriter: saves a file through a temporary sibling that replaces
+// the target only once everything was written, so a crash or a full disk
+// never leaves a half-written cache or index behind.
+//==============================================================================
+namespace AtomicFileWriter {
+// writeContent fills the stream; returns false if nothing replaced the target
+bool write(const juce::File &target,
+           const std::function<void(juce::OutputStream &)> &writeContent);
+} // namespace AtomicFileWriter
@@ -0,0 +1,327 @@
+#include "AuditionEngine.h"
+
+AuditionEngine::AuditionEngine(std::array<IRSlot, 4> &s, IRLoader &l)
+    : juce::Thread("FreeIR Audition"), slots(s), loader(l) {
+  for (auto &engine : engines)
+    engine = std::make_unique<juce::dsp::Convolution>(
+        juce::dsp::Convolution::Latency{0}, convolutionQueue);
+}
+
+AuditionEngine::~AuditionEngine() {
+  signalThreadShouldExit();
+  notify();
+  stopThread(4000);
+}
+
+void AuditionEngine::prepare(const juce::dsp::ProcessSpec &spec) {
+  sampleRate = spec.sampleRate;
+  for (auto &engine : engines)
+    engine->prepare(spec);
+
+  auditionBuffer.setSize(2, (int)spec.maximumBlockSize);
+  fadeBuffer.setSize(2, (int)spec.maximumBlockSize);
+  warmUpBuffer.setSize(2, (int)spec.maximumBlockSize);
+  for (size_t i = 0; i < (size_t)poolSize; ++i) {
+    warmingSerial[i] = loadSerial[i];
+    warmUpLeft[i] = 0;
+  }
+  engineFade.reset(sampleRate, fadeSeconds);
+  slotMix.reset(sampleRate, fadeSeconds);
+  engineFade.setCurrentAndTargetValue(1.0f);
+  slotMix.setCurrentAndTargetValue(0.0f);
+  activeSlot = -1;
+  currentEngine = -1;
+  previousEngine = -1;
+  handingBack = false;
+
+  // Kernel gains depend on the host rate, so every engine is refilled
+  const juce::ScopedLock sl(lock);
+  held.fill({});
+  toLoad = wanted;
+  requestedEngine = -1;
+  notify();
+}
+
+void AuditionEngine::arm(int slotIndex) {
+  {
+    const juce::ScopedLock sl(lock);
+    wanted.clear();
+    toLoad.clear();
+    requestedEngine = -1;
+  }
+  armedSlot = slotIndex;
+}
+
+void AuditionEngine::audition(std::vector<juce::File> files) {
+  if (armedSlot < 0)
+    return;
+
+  {
+    const juce::ScopedLock sl(lock);
+    wanted = std::move(files);
+    toLoad = wanted;
+
+    // Already loaded: heard from the next block on
+    if (!wanted.empty()) {
+      int ready = findReadyEngine(wanted.front());
+      if (ready >= 0)
+        requestedEngine = ready;
+    }
+  }
+
+  if (!isThreadRunning())
+    startThread(juce::Thread::Priority::normal);
+  notify();
+}
+
+void AuditionEngine::commit() {
+  int slotIndex = armedSlot;
+  if (slotIndex < 0)
+    return;
+
+  juce::File file;
+  IRAsset::Ptr asset;
+  {
+    const juce::ScopedLock sl(lock);
+    int engine = requestedEngine;
+    if (engine >= 0) {
+      file = held[(size_t)engine].file;
+      asset = held[(size_t)engine].asset;
+    }
+  }
+
+  // The slot's convolver builds the kernel while the hand-back warms up
+  arm(-1);
+  if (asset != nullptr)
+    slots[(size_t)slotIndex].loadImpulseResponse(file, asset);
+}
+
+int AuditionEngine::findReadyEngine(const juce::File &file) const {
+  for (int i = 0; i < poolSize; ++i)
+    if (held[(size_t)i].ready && held[(size_t)i].file == file)
+      return i;
+  return -1;
+}
+
+bool AuditionEngine::promoteWarmEngines() {
+  bool warming = false;
+  for (int i = 0; i < poolSize; ++i) {
+    auto &h = held[(size_t)i];
+    if (h.asset == nullptr || h.ready)
+      continue;
+
+    if (warmSerial[(size_t)i] != h.serial) {
+      warming = true;
+      continue;
+    }
+
+    h.ready = true;
+    if (!wanted.empty() && wanted.front() == h.file)
+      requestedEngine = i;
+  }
+  return warming;
+}
+
+//==============================================================================
+void AuditionEngine::run() {
+  while (!threadShouldExit()) {
+    juce::File file;
+    bool warming = false;
+    {
+      const juce::ScopedLock sl(lock);
+      warming = promoteWarmEngines();
+      while (!toLoad.empty() && file == juce::File()) {
+        auto next = toLoad.front();
+        toLoad.erase(toLoad.begin());
+        if (findReadyEngine(next) < 0)
+          file = next;
+      }
+    }
+
+    // The audio thread reports warmed engines without waking this thread
+    if (file == juce::File()) {
+      wait(warming ? warmUpPollMs : -1);
+      continue;
+    }
+
+    auto asset = loader.decode(file);
+    if (asset == nullptr)
+      continue;
+
+    // Any engine that is neither heard nor holding a wanted IR
+    int engine = -1;
+    {
+      const juce::ScopedLock sl(lock);
+      if (std::find(wanted.begin(), wanted.end(), file) == wanted.end())
+        continue;
+
+      for (int i = 0; i < poolSize && engine < 0; ++i) {
+        bool heard = i == currentEngine || i == previousEngine ||
+                     i == requestedEngine;
+        bool isWanted = std::find(wanted.begin(), wanted.end(),
+                                  held[(size_t)i].file) != wanted.end();
+        if (!heard && !isWanted)
+          engine = i;
+      }
+      if (engine < 0)
+        continue;
+      held[(size_t)engine] = {file, asset};
+    }
+
+    // Kernel gains are the same for every slot
+    auto &slot = slots[(size_t)juce::jmax(0, armedSlot.load())];
+    engines[(size_t)engine]->loadImpulseResponse(
+        slot.makeLiveKernel(*asset), asset->getSampleRate(),
+        juce::dsp::Convolution::Stereo::yes, juce::dsp::Convolution::Trim::yes,
+        juce::dsp::Convolution::Normalise::no);
+
+    // Ready once the audio thread has run it long enough to swap it in
+    const juce::ScopedLock sl(lock);
+    held[(size_t)engine].serial = ++loadSerial[(size_t)engine];
+  }
+}
+
+//==============================================================================
+void AuditionEngine::warmUpEngines(int numSamples) {
+  numSamples = juce::jmin(numSamples, warmUpBuffer.getNumSamples());
+  auto silence = juce::dsp::AudioBlock<float>(warmUpBuffer)
+                     .getSubBlock(0, (size_t)numSamples);
+
+  for (size_t i = 0; i < (size_t)poolSize; ++i) {
+    uint32_t serial = loadSerial[i];
+    if (serial != warmingSerial[i]) {
+      warmingSerial[i] = serial;
+      warmUpLeft[i] = (int)(engineWarmUpSeconds * sampleRate);
+    }
+    if (warmUpLeft[i] <= 0)
+      continue;
+
+    silence.clear();
+    juce::dsp::ProcessContextReplacing<float> context(silence);
+    engines[i]->process(context);
+
+    warmUpLeft[i] -= numSamples;
+    if (warmUpLeft[i] <= 0)
+      warmSerial[i] = serial;
+  }
+}
+
+void AuditionEngine::update(int numSamples) {
+  warmUpEngines(numSamples);
+  int armed = armedSlot;
+
+  if (activeSlot < 0) {
+    // Start once the first selection is playable
+    if (armed < 0 || requestedEngine < 0)
+      return;
+    activeSlot = armed;
+    currentEngine = -1;
+    previousEngine = -1;
+    slotMix.setCurrentAndTargetValue(0.0f);
+    slotMix.setTargetValue(1.0f);
+    return;
+  }
+
+  const auto &slot = slots[(size_t)activeSlot.load()];
+  if (armed != activeSlot && !handingBack) {
+    handingBack = true;
+    ownNeedsReset = true;
+    warmUpSamples = (int)(handBackWarmUpSeconds * sampleRate);
+  }
+  if (!handingBack)
+    return;
+
+  if (warmUpSamples > 0)
+    warmUpSamples -= numSamples;
+  else
+    slotMix.setTargetValue(0.0f);
+
+  // A muted slot is not processed, so it cannot fade
+  bool faded = warmUpSamples <= 0 && !slotMix.isSmoothing() &&
+               slotMix.getCurrentValue() <= 0.0f;
+  if (faded || slot.isMuted()) {
+    activeSlot = -1;
+    currentEngine = -1;
+    previousEngine = -1;
+    handingBack = false;
+  }
+}
+
+void AuditionEngine::process(
+    const juce::dsp::ProcessContextReplacing<float> &context,
+    juce::dsp::Convolution &own) {
+  auto &block = context.getOutputBlock();
+  auto numSamples = block.getNumSamples();
+  int numChannels = (int)juce::jmin((size_t)2, block.getNumChannels());
+
+  // 1. Switch to the requested engine, keeping the outgoing one for the fade
+  int requested = requestedEngine;
+  if (requested >= 0 && requested != currentEngine) {
+    bool fading = previousEngine >= 0 && engineFade.isSmoothing();
+    if (currentEngine >= 0 &&
+        (!fading || engineFade.getCurrentValue() >= 0.5f))
+      previousEngine = currentEngine.load();
+    currentEngine = requested;
+    engines[(size_t)requested]->reset();
+    engineFade.setCurrentAndTargetValue(previousEngine >= 0 ? 0.0f : 1.0f);
+    engineFade.setTargetValue(1.0f);
+  }
+
+  // 2. The audition output, crossfading engines while a switch is under way
+  auto audition = juce::dsp::AudioBlock<float>(auditionBuffer)
+                      .getSubsetChannelBlock(0, (size_t)numChannels)
+                      .getSubBlock(0, numSamples);
+  audition.clear();
+  if (currentEngine >= 0) {
+    audition.copyFrom(block);
+    juce::dsp::ProcessContextReplacing<float> current(audition);
+    engines[(size_t)currentEngine.load()]->process(current);
+  }
+
+  if (previousEngine >= 0 && engineFade.isSmoothing()) {
+    auto fade = juce::dsp::AudioBlock<float>(fadeBuffer)
+                    .getSubsetChannelBlock(0, (size_t)numChannels)
+                    .getSubBlock(0, numSamples);
+    fade.copyFrom(block);
+    juce::dsp::ProcessContextReplacing<float> previous(fade);
+    engines[(size_t)previousEngine.load()]->process(previous);
+
+    for (size_t i = 0; i < numSamples; ++i) {
+      float g = engineFade.getNextValue();
+      for (int ch = 0; ch < numChannels; ++ch)
+        audition.setSample(ch, (int)i,
+                           fade.getSample(ch, (int)i) * (1.0f - g) +
+                               audition.getSample(ch, (int)i) * g);
+    }
+  } else {
+    engineFade.skip((int)numSamples);
+    previousEngine = -1;
+  }
+
+  // 3. The slot's own convolver, while it is heard or warming back up
+  if (ownNeedsReset) {
+    own.reset();
+    ownNeedsReset = false;
+  }
+  bool ownRunning = handingBack || slotMix.isSmoothing() ||
+                    slotMix.getCurrentValue() < 1.0f;
+  if (!ownRunning) {
+    block.copyFrom(audition);
+    slotMix.skip((int)numSamples);
+    return;
+  }
+
+  // An empty slot has nothing of its own to fade against
+  if (slots[(size_t)activeSlot.load()].isLoaded())
+    own.process(context);
+  else
+    block.clear();
+
+  for (size_t i = 0; i < numSamples; ++i) {
+    float m = slotMix.getNextValue();
+    for (int ch = 0; ch < numChannels; ++ch)
+      block.setSample(ch, (int)i,
+                      block.getSample(ch, (int)i) * (1.0f - m) +
+                          audition.getSample(ch, (int)i) * m);
+  }
+}
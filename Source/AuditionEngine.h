@@ -0,0 +1,116 @@
+#pragma once
+
+#include "IRLoader.h"
+#include "IRSlot.h"
+#include <JuceHeader.h>
+
+//==============================================================================
+// AuditionEngine: plays the IR under the browser's selection through one
+// slot, without loading it into the slot.
+//
+// A small pool of convolution engines is kept loaded with the selected IR
+// and its neighbouring rows, so moving the selection switches to an engine
+// that is already built and the two crossfade. The slot's own convolver
+// keeps its IR all along: reverting fades back to it, committing loads the
+// auditioned IR into the slot. An empty slot can be auditioned too; it
+// fades in from silence. Engines are filled on a background thread and
+// then run on silence by the audio thread until the convolver has swapped
+// the new kernel in; only then can they be heard. The audio thread never
+// allocates or locks.
+//==============================================================================
+class AuditionEngine : private juce::Thread {
+public:
+  AuditionEngine(std::array<IRSlot, 4> &slots, IRLoader &loader);
+  ~AuditionEngine() override;
+
+  // From prepareToPlay, with the audio thread stopped
+  void prepare(const juce::dsp::ProcessSpec &spec);
+
+  // Message thread: play the browser's selection through a slot (-1 stops,
+  // fading back to the slot's own IR)
+  void arm(int slotIndex);
+  int getArmedSlot() const { return armedSlot; }
+
+  // Message thread: the selected IR first, then the rows around it
+  void audition(std::vector<juce::File> files);
+
+  // Message thread: load the IR being heard into the armed slot and stop
+  void commit();
+  void revert() { arm(-1); }
+
+  // Audio thread, once per block before the slots run
+  void update(int numSamples);
+  bool isActive() const { return activeSlot >= 0; }
+  bool isActiveFor(int slotIndex) const { return activeSlot == slotIndex; }
+
+  // Audio thread, from the active slot's live pair, in place of
+  // own.process(context)
+  void process(const juce::dsp::ProcessContextReplacing<float> &context,
+               juce::dsp::Convolution &own);
+
+  // The selected row, one either side, and one left to finish a crossfade
+  static constexpr int poolSize = 4;
+
+private:
+  void run() override;
+
+  // Guarded by lock: the engine for file once it is loaded, or -1
+  int findReadyEngine(const juce::File &file) const;
+
+  // Guarded by lock: marks the engines the audio thread has warmed up as
+  // ready; true while some are still warming
+  bool promoteWarmEngines();
+
+  // Audio thread: runs the engines with a fresh kernel on silence
+  void warmUpEngines(int numSamples);
+
+  std::array<IRSlot, 4> &slots;
+  IRLoader &loader;
+
+  // Shared by the pool so it needs one loading thread, not four
+  juce::dsp::ConvolutionMessageQueue convolutionQueue;
+  std::array<std::unique_ptr<juce::dsp::Convolution>, poolSize> engines;
+
+  struct Held {
+    juce::File file;
+    IRAsset::Ptr asset; // Kept for commit()
+    uint32_t serial = 0; // loadSerial of its kernel
+    bool ready = false;
+  };
+
+  juce::CriticalSection lock;
+  std::array<Held, poolSize> held;   // Guarded by lock
+  std::vector<juce::File> wanted;    // Guarded by lock
+  std::vector<juce::File> toLoad;    // Guarded by lock
+  std::atomic<int> armedSlot{-1};
+  std::atomic<int> requestedEngine{-1}; // Set under lock, read by audio
+
+  // Bumped by the loading thread after each kernel load; the audio thread
+  // copies it to warmSerial once that kernel has been warmed up
+  std::array<std::atomic<uint32_t>, poolSize> loadSerial{}, warmSerial{};
+
+  // Audio thread; the engine indices are published for the loading thread
+  std::atomic<int> activeSlot{-1};
+  std::atomic<int> currentEngine{-1}, previousEngine{-1};
+  juce::SmoothedValue<float> engineFade; // previous -> current
+  juce::SmoothedValue<float> slotMix;    // slot's own IR -> audition
+  bool handingBack = false;
+  bool ownNeedsReset = false;
+  int warmUpSamples = 0;
+  juce::AudioBuffer<float> auditionBuffer, fadeBuffer, warmUpBuffer;
+  std::array<uint32_t, poolSize> warmingSerial{};
+  std::array<int, poolSize> warmUpLeft{};
+  double sampleRate = 48000.0;
+
+  // A loaded engine runs unheard this long: the convolver swaps the kernel
+  // in on its next process() and then crossfades to it over 50 ms
+  static constexpr double engineWarmUpSeconds = 0.15;
+  static constexpr int warmUpPollMs = 10;
+
+  // The slot's convolver restarts cold when it is handed back and gets this
+  // long, still unheard, before the fade; commit() loads it meanwhile
+  static constexpr double handBackWarmUpSeconds = 0.15;
+  static constexpr double fadeSeconds = 0.03;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(AuditionEngine)
+};
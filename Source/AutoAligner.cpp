@@ -1,115 +1,494 @@
 #include "AutoAligner.h"
 
+namespace {
+// Mono sum of the first numSamples of an IR, linearly resampled to
+// analysisRate (zero-padded past the end of the IR)
+std::vector<float> makeAnalysisSignal(const juce::AudioBuffer<float> &ir,
+                                      double irRate, double analysisRate,
+                                      int numSamples) {
+  std::vector<float> mono((size_t)numSamples, 0.0f);
+  int numChannels = ir.getNumChannels();
+  int irLength = ir.getNumSamples();
+  if (numChannels == 0 || irLength == 0)
+    return mono;
+
+  double step = irRate / analysisRate;
+  float channelGain = 1.0f / (float)numChannels;
+
+  for (int ch = 0; ch < numChannels; ++ch) {
+    const float *src = ir.getReadPointer(ch);
+    for (int i = 0; i < numSamples; ++i) {
+      double srcPos = i * step;
+      int idx = (int)srcPos;
+      if (idx >= irLength)
+        break;
+      float frac = (float)(srcPos - idx);
+      float next = idx + 1 < irLength ? src[idx + 1] : 0.0f;
+      mono[(size_t)i] +=
+          (src[idx] * (1.0f - frac) + next * frac) * channelGain;
+    }
+  }
+  return mono;
+}
+} // namespace
+
 AutoAligner::AutoAligner(std::array<IRSlot, 4> &s)
-    : juce::Thread("AutoAligner"), slots(s) {}
+    : juce::Thread("AutoAligner"), slots(s),
+      pairPool(juce::jlimit(1, maxPairs,
+                            juce::SystemStats::getNumCpus() - 1)) {}
 
-AutoAligner::~AutoAligner() { stopThread(2000); }
+AutoAligner::~AutoAligner() {
+  // The jobs call back into this object, so they go before the thread does
+  signalThreadShouldExit();
+  notify();
+  pairPool.removeAllJobs(true, 2000);
+  stopThread(2000);
+}
+
+void AutoAligner::setSettings(const Settings &newSettings) {
+  settings.windowMs = juce::jlimit(0.5, maxAnalysisMs, newSettings.windowMs);
+  settings.searchRangeMs =
+      juce::jlimit(0.1, maxAnalysisMs, newSettings.searchRangeMs);
+  settings.phatWeighting = newSettings.phatWeighting;
+  settings.objective = newSettings.objective;
+  settings.bandLoHz = juce::jlimit(20.0, 20000.0, newSettings.bandLoHz);
+  settings.bandHiHz =
+      juce::jlimit(settings.bandLoHz + 10.0, 24000.0, newSettings.bandHiHz);
+}
 
 void AutoAligner::performAlignment() {
-  if (isThreadRunning())
+  if (busy)
     return;
-  startThread();
+
+  // The thread stays up between requests and sleeps until notified
+  if (!isThreadRunning())
+    startThread();
+
+  jobSettings = settings;
+  busy = true;
+  notify();
 }
 
 void AutoAligner::run() {
-  // 1. Find reference slot (first loaded slot)
-  int refIndex = -1;
-  for (int i = 0; i < 4; ++i) {
-    if (slots[i].isLoaded()) {
-      refIndex = i;
-      break;
-    }
-  }
+  while (!threadShouldExit()) {
+    wait(-1);
+    if (threadShouldExit())
+      return;
+    if (!busy)
+      continue;
 
-  if (refIndex < 0) {
-    // No slots loaded
+    solveAlignment();
+    busy = false;
+
+    // Notify listeners on message thread
     juce::MessageManager::callAsync(
         [this]() { listeners.call(&Listener::alignmentComplete); });
+  }
+}
+
+void AutoAligner::solveAlignment() {
+  // Snapshot the IRs once; the slots may load something else meanwhile
+  auto run = std::make_shared<PairRun>();
+  auto &assets = run->assets;
+  std::array<int, 4> loaded{};
+  int numLoaded = 0;
+  for (int i = 0; i < 4; ++i) {
+    assets[(size_t)i] = slots[(size_t)i].getAsset();
+    if (assets[(size_t)i] != nullptr)
+      loaded[(size_t)numLoaded++] = i;
+  }
+
+  results = {0.0, 0.0, 0.0, 0.0};
+  confidence = {0.0, 0.0, 0.0, 0.0};
+  outOfRange = {false, false, false, false};
+  if (numLoaded == 0)
+    return;
+  if (numLoaded == 1) {
+    confidence[(size_t)loaded[0]] = 1.0;
     return;
   }
 
-  const auto &refIR = slots[refIndex].getIRBuffer();
-  double refSR = slots[refIndex].getIRSampleRate();
+  // 1. Correlate every pair of loaded slots on the pool
+  auto &pairs = run->pairs;
+  int numPairs = 0;
+  for (int a = 0; a < numLoaded; ++a)
+    for (int b = a + 1; b < numLoaded; ++b)
+      pairs[(size_t)numPairs++] = {loaded[(size_t)a], loaded[(size_t)b]};
 
-  // Reset reference delay to 0
-  results[refIndex] = 0.0;
+  // Pairs seen before (in this session or an earlier one) come from the
+  // cache; only the rest go to the pool
+  std::array<int, maxPairs> misses{};
+  int numMisses = 0;
+  for (int p = 0; p < numPairs; ++p) {
+    auto &pair = pairs[(size_t)p];
+    AlignmentCache::Entry cached;
+    if (cache.lookup(makeCacheKey(*assets[(size_t)pair.first],
+                                  *assets[(size_t)pair.second]),
+                     cached))
+      pair.lag = {cached.lagMs, cached.strength};
+    else
+      misses[(size_t)numMisses++] = p;
+  }
 
-  // 2. For each other loaded slot, compute cross-correlation offset
-  for (int i = 0; i < 4; ++i) {
+  run->remaining = numMisses;
+  for (int m = 0; m < numMisses; ++m) {
+    pairPool.addJob([this, run, p = misses[(size_t)m]] {
+      if (!threadShouldExit()) {
+        auto &pair = run->pairs[(size_t)p];
+        const auto &ref = *run->assets[(size_t)pair.first];
+        const auto &target = *run->assets[(size_t)pair.second];
+        pair.lag = findDelayOffset(ref, target);
+        cache.store(makeCacheKey(ref, target),
+                    {pair.lag.ms, pair.lag.strength});
+      }
+      if (--run->remaining == 0)
+        run->allDone.signal();
+    });
+  }
+
+  // Timed, so jobs removed on shutdown cannot leave the thread blocked
+  while (numMisses > 0 && !run->allDone.wait(jobPollMs))
     if (threadShouldExit())
       return;
 
-    if (i == refIndex || !slots[i].isLoaded()) {
-      if (i != refIndex)
-        results[i] = 0.0;
-      continue;
+  if (threadShouldExit())
+    return;
+  if (numMisses > 0)
+    cache.save();
+
+  // 2. Weighted least squares for the arrival times t: every pair says
+  // t[second] - t[first] = lag.ms with weight lag.strength. The first
+  // loaded slot is pinned at 0, which leaves an (n-1)x(n-1) system.
+  auto column = [&loaded, numLoaded](int slot) {
+    for (int k = 1; k < numLoaded; ++k)
+      if (loaded[(size_t)k] == slot)
+        return k - 1;
+    return -1;
+  };
+
+  int n = numLoaded - 1;
+  double normal[3][4] = {}; // Augmented normal equations
+  for (int p = 0; p < numPairs; ++p) {
+    const auto &pair = pairs[(size_t)p];
+    double w = juce::jmax(minPairWeight, pair.lag.strength);
+    int a = column(pair.first), b = column(pair.second);
+
+    // Residual: t[b] - t[a] - ms
+    if (b >= 0) {
+      normal[b][b] += w;
+      normal[b][n] += w * pair.lag.ms;
+    }
+    if (a >= 0) {
+      normal[a][a] += w;
+      normal[a][n] -= w * pair.lag.ms;
+    }
+    if (a >= 0 && b >= 0) {
+      normal[a][b] -= w;
+      normal[b][a] -= w;
+    }
+  }
+
+  // Gaussian elimination; the system is symmetric positive definite
+  // because every slot is paired with the pinned one
+  for (int k = 0; k < n; ++k) {
+    for (int r = k + 1; r < n; ++r) {
+      double f = normal[r][k] / normal[k][k];
+      for (int c = k; c <= n; ++c)
+        normal[r][c] -= f * normal[k][c];
+    }
+  }
+  std::array<double, 4> arrival{};
+  for (int k = n - 1; k >= 0; --k) {
+    double sum = normal[k][n];
+    for (int c = k + 1; c < n; ++c)
+      sum -= normal[k][c] * arrival[(size_t)loaded[(size_t)c + 1]];
+    arrival[(size_t)loaded[(size_t)k + 1]] = sum / normal[k][k];
+  }
+
+  // 3. Delay everyone up to a reference arrival, so no offset is negative.
+  // The reference is the arrival that brings the most slots within
+  // maxDelayMs; the rest cannot be reached by the delay parameter.
+  auto offsetTo = [&arrival](int reference, int slot) {
+    return arrival[(size_t)reference] - arrival[(size_t)slot];
+  };
+  auto inRange = [&offsetTo](int reference, int slot) {
+    double offset = offsetTo(reference, slot);
+    return offset >= 0.0 && offset <= maxDelayMs;
+  };
+
+  int reference = loaded[0];
+  int mostInRange = 0;
+  for (int r = 0; r < numLoaded; ++r) {
+    int count = 0;
+    for (int k = 0; k < numLoaded; ++k)
+      count += inRange(loaded[(size_t)r], loaded[(size_t)k]) ? 1 : 0;
+    if (count > mostInRange) {
+      mostInRange = count;
+      reference = loaded[(size_t)r];
     }
+  }
+
+  for (int k = 0; k < numLoaded; ++k) {
+    int slot = loaded[(size_t)k];
+    if (inRange(reference, slot))
+      results[(size_t)slot] = offsetTo(reference, slot);
+    else
+      outOfRange[(size_t)slot] = true;
+  }
+
+  // 4. Confidence: how strong each slot's pair peaks were, discounted by
+  // how far the solution had to bend them (1 / (1 + residual in samples))
+  std::array<double, 4> weightSum{};
+  for (int p = 0; p < numPairs; ++p) {
+    const auto &pair = pairs[(size_t)p];
+    double residualMs = arrival[(size_t)pair.second] -
+                        arrival[(size_t)pair.first] - pair.lag.ms;
+    double residualSamples = std::abs(residualMs) * 0.001 *
+                             assets[(size_t)pair.first]->getSampleRate();
+    double agreement =
+        juce::jlimit(0.0, 1.0, pair.lag.strength) / (1.0 + residualSamples);
 
-    const auto &targetIR = slots[i].getIRBuffer();
-    // double targetSR = slots[i].getIRSampleRate(); // Unused
+    for (int slot : {pair.first, pair.second}) {
+      confidence[(size_t)slot] += agreement;
+      weightSum[(size_t)slot] += 1.0;
+    }
+  }
+  for (int k = 0; k < numLoaded; ++k) {
+    auto slot = (size_t)loaded[(size_t)k];
+    confidence[slot] =
+        outOfRange[slot] ? 0.0 : confidence[slot] / weightSum[slot];
+  }
+}
 
-    // Use the lower sample rate for safety
-    double offset = findDelayOffset(refIR, targetIR, refSR);
-    results[i] = offset;
+AlignmentCache::Key AutoAligner::makeCacheKey(const IRAsset &ref,
+                                              const IRAsset &target) const {
+  // Everything in the settings that changes the answer, plus a version to
+  // bump whenever the algorithm itself does
+  uint64_t settingsHash = 14695981039346656037ull;
+  auto mix = [&settingsHash](double value) {
+    auto bits = (uint64_t)juce::roundToInt(value * 1000.0);
+    settingsHash = (settingsHash ^ bits) * 1099511628211ull;
+  };
+  mix(algorithmVersion);
+  mix(jobSettings.windowMs);
+  mix(jobSettings.searchRangeMs);
+  mix((double)(int)jobSettings.objective);
+  if (jobSettings.objective == Objective::peakCorrelation) {
+    mix(jobSettings.phatWeighting ? 1.0 : 0.0);
+  } else {
+    mix(jobSettings.bandLoHz);
+    mix(jobSettings.bandHiHz);
   }
 
-  // 3. Notify listeners on message thread
-  juce::MessageManager::callAsync(
-      [this]() { listeners.call(&Listener::alignmentComplete); });
+  return {ref.getContentHash(), target.getContentHash(), settingsHash,
+          ref.getSampleRate(), target.getSampleRate()};
 }
 
-double AutoAligner::findDelayOffset(const juce::AudioBuffer<float> &ref,
-                                    const juce::AudioBuffer<float> &target,
-                                    double sr) {
-  // Cross-correlation in time domain on the early portion of both IRs
-  // Limit analysis window to first 5ms as per PRD
-  int windowSamples = juce::jmin((int)(sr * 0.005), ref.getNumSamples(),
-                                 target.getNumSamples());
-  if (windowSamples < 2)
-    return 0.0;
+AutoAligner::Lag AutoAligner::findDelayOffset(const IRAsset &refAsset,
+                                              const IRAsset &targetAsset) {
+  const auto &ref = refAsset.getBuffer();
+  const auto &target = targetAsset.getBuffer();
+  double sr = refAsset.getSampleRate();
+  double targetSR = targetAsset.getSampleRate();
+
+  // Cross-correlate the early portion of both IRs (mono sums) at the
+  // reference rate. The reference window is matched against the target
+  // window extended by the search range, so every lag in ±maxLag sees a
+  // full overlap where the target has data.
+  int windowSamples = juce::jmin((int)(sr * jobSettings.windowMs * 0.001),
+                                 ref.getNumSamples());
+  int maxLag = (int)(sr * jobSettings.searchRangeMs * 0.001);
+  if (windowSamples < 2 || maxLag < 1 || target.getNumSamples() < 2)
+    return {};
+
+  int targetSamples = windowSamples + maxLag;
+  auto refData = makeAnalysisSignal(ref, sr, sr, windowSamples);
+  auto tgtData = makeAnalysisSignal(target, targetSR, sr, targetSamples);
+
+  // Linear (not circular) correlation needs room for both signals
+  int order = juce::jmax(
+      1, juce::roundToInt(std::ceil(
+             std::log2((double)(windowSamples + targetSamples)))));
+  int fftSize = 1 << order;
+  juce::dsp::FFT fft(order);
 
-  // Use mono (channel 0 or sum) for correlation
-  const float *refData = ref.getReadPointer(0);
-  const float *tgtData = target.getReadPointer(0);
+  std::vector<float> refSpectrum((size_t)(2 * fftSize), 0.0f);
+  std::vector<float> cross((size_t)(2 * fftSize), 0.0f);
+  std::copy(refData.begin(), refData.end(), refSpectrum.begin());
+  std::copy(tgtData.begin(), tgtData.end(), cross.begin());
+  fft.performRealOnlyForwardTransform(refSpectrum.data());
+  fft.performRealOnlyForwardTransform(cross.data());
 
-  // Search range: ±5ms
-  int maxLag = (int)(sr * 0.005);
-  maxLag = juce::jmin(maxLag, windowSamples - 1);
+  // Cross spectrum conj(Ref) * Tgt
+  auto *r = reinterpret_cast<std::complex<float> *>(refSpectrum.data());
+  auto *x = reinterpret_cast<std::complex<float> *>(cross.data());
+  for (int k = 0; k < fftSize; ++k)
+    x[k] = std::conj(r[k]) * x[k];
+
+  if (jobSettings.objective == Objective::bandCoherence)
+    return findCoherentLag(x, fftSize, fft, sr, maxLag);
+
+  // Optionally whitened so only the phase is left
+  if (jobSettings.phatWeighting)
+    for (int k = 0; k < fftSize; ++k)
+      x[k] /= std::abs(x[k]) + 1.0e-12f;
+  fft.performRealOnlyInverseTransform(cross.data());
+
+  // Lag l sits at index l, negative lags wrap to the end
+  auto at = [&cross, fftSize](int lag) {
+    return (double)cross[(size_t)((lag + fftSize) % fftSize)];
+  };
 
   double bestCorr = -1e30;
   int bestLag = 0;
+  for (int lag = -maxLag; lag <= maxLag; ++lag) {
+    double corr = at(lag);
+    if (corr > bestCorr) {
+      bestCorr = corr;
+      bestLag = lag;
+    }
+  }
+
+  // Sub-sample peak: vertex of the parabola through the peak and its
+  // neighbours (left alone at the edges of the search range)
+  double fraction = 0.0;
+  if (bestLag > -maxLag && bestLag < maxLag) {
+    double left = at(bestLag - 1), right = at(bestLag + 1);
+    double curvature = left - 2.0 * bestCorr + right;
+    if (curvature < 0.0)
+      fraction = juce::jlimit(-0.5, 0.5, 0.5 * (left - right) / curvature);
+  }
+
+  // Peak height on a 0..1 scale: PHAT peaks are already normalised, plain
+  // correlation is divided by the geometric mean of the two energies
+  double strength = bestCorr;
+  if (!jobSettings.phatWeighting) {
+    double refEnergy = 0.0, tgtEnergy = 0.0;
+    for (float v : refData)
+      refEnergy += (double)v * v;
+    for (float v : tgtData)
+      tgtEnergy += (double)v * v;
+    double norm = std::sqrt(refEnergy * tgtEnergy);
+    strength = norm > 0.0 ? bestCorr / norm : 0.0;
+  }
 
+  // Positive: the target's content arrives after the reference's
+  return {((double)bestLag + fraction) / sr * 1000.0,
+          juce::jlimit(0.0, 1.0, strength)};
+}
+
+AutoAligner::Lag AutoAligner::findCoherentLag(std::complex<float> *cross,
+                                              int fftSize,
+                                              juce::dsp::FFT &fft, double sr,
+                                              int maxLag) {
+  // Summing the reference delayed by tau with the target gives, per bin,
+  //   |R|^2 + |T|^2 + 2 Re(conj(R) T e^{j w tau})
+  // so the band energy of the blend is maximised by the tau that
+  // maximises sum over the band of Re(X e^{j w tau}). Bins outside the
+  // band do not count, so HF transients cannot win over low-mid combing.
+  int lo = juce::jmax(1, (int)std::ceil(jobSettings.bandLoHz * fftSize / sr));
+  int hi = juce::jmin(fftSize / 2 - 1,
+                      (int)std::floor(jobSettings.bandHiHz * fftSize / sr));
+  if (hi < lo)
+    return {};
+
+  int numBins = hi - lo + 1;
+  std::vector<float> xr((size_t)numBins), xi((size_t)numBins),
+      omega((size_t)numBins);
+  double totalMagnitude = 0.0;
+  for (int k = lo; k <= hi; ++k) {
+    auto i = (size_t)(k - lo);
+    xr[i] = cross[k].real();
+    xi[i] = cross[k].imag();
+    omega[i] = (float)(juce::MathConstants<double>::twoPi * k / fftSize);
+    totalMagnitude += std::abs(cross[k]);
+  }
+  if (totalMagnitude <= 0.0)
+    return {};
+
+  // 1. Coarse: the objective at every integer lag in one inverse FFT of
+  // the band-limited cross spectrum
+  for (int k = 0; k < fftSize; ++k) {
+    int bin = k <= fftSize / 2 ? k : fftSize - k;
+    if (bin < lo || bin > hi)
+      cross[k] = {};
+  }
+  auto *coarse = reinterpret_cast<float *>(cross);
+  fft.performRealOnlyInverseTransform(coarse);
+
+  auto at = [coarse, fftSize](int lag) {
+    return coarse[(lag + fftSize) % fftSize];
+  };
+
+  // Keep the strongest local maxima; combing can make a near-tie between
+  // neighbouring peaks that only the fine pass can settle
+  std::array<int, numRefinedPeaks> peaks{};
+  std::array<float, numRefinedPeaks> peakValues;
+  peakValues.fill(-1e30f);
   for (int lag = -maxLag; lag <= maxLag; ++lag) {
-    double sum = 0.0;
-    int count = 0;
+    float v = at(lag);
+    bool isPeak = (lag == -maxLag || v >= at(lag - 1)) &&
+                  (lag == maxLag || v >= at(lag + 1));
+    if (!isPeak || v <= peakValues.back())
+      continue;
 
-    for (int i = 0; i < windowSamples; ++i) {
-      int j = i + lag;
-      if (j >= 0 && j < target.getNumSamples()) {
-        sum += (double)refData[i] * (double)tgtData[j];
-        count++;
-      }
+    int slot = numRefinedPeaks - 1;
+    while (slot > 0 && peakValues[(size_t)slot - 1] < v) {
+      peakValues[(size_t)slot] = peakValues[(size_t)slot - 1];
+      peaks[(size_t)slot] = peaks[(size_t)slot - 1];
+      --slot;
     }
+    peakValues[(size_t)slot] = v;
+    peaks[(size_t)slot] = lag;
+  }
 
-    if (count > 0)
-      sum /= (double)count;
+  // 2. Fine: every candidate within a sample of each peak, in steps of
+  // 1 / subSampleSteps. The band is held as separate re/im/omega arrays,
+  // and each candidate advances every bin's phasor by one complex multiply,
+  // so the inner loops are straight-line float arithmetic that vectorises.
+  std::vector<float> phasors((size_t)(4 * numBins));
+  float *pRe = phasors.data(), *pIm = pRe + numBins;
+  float *dRe = pIm + numBins, *dIm = dRe + numBins;
+  const float *cRe = xr.data(), *cIm = xi.data(), *w = omega.data();
 
-    if (sum > bestCorr) {
-      bestCorr = sum;
-      bestLag = lag;
-    }
+  float step = 1.0f / (float)subSampleSteps;
+  for (int b = 0; b < numBins; ++b) {
+    dRe[b] = std::cos(w[b] * step);
+    dIm[b] = std::sin(w[b] * step);
   }
 
-  // bestLag > 0 means target needs to be delayed to align with ref
-  // bestLag < 0 means target arrives earlier (so we delay it less, or ref needs
-  // delay — but we fix ref at 0) We want to apply a positive delay to shift the
-  // target forward in time
-  double delayMs = (double)bestLag / sr * 1000.0;
+  double bestScore = -1e30;
+  double bestTau = 0.0;
+  for (int p = 0; p < numRefinedPeaks; ++p) {
+    if (peakValues[(size_t)p] <= -1e30f)
+      break;
+
+    float tau0 = (float)peaks[(size_t)p] - 1.0f;
+    for (int b = 0; b < numBins; ++b) {
+      pRe[b] = std::cos(w[b] * tau0);
+      pIm[b] = std::sin(w[b] * tau0);
+    }
+
+    for (int m = 0; m <= 2 * subSampleSteps; ++m) {
+      float score = 0.0f;
+      for (int b = 0; b < numBins; ++b)
+        score += cRe[b] * pRe[b] - cIm[b] * pIm[b];
 
-  // Clamp to 0..10ms (negative means this slot should play EARLIER than ref; we
-  // can't do negative delay, so we clamp to 0 which means it's as aligned as we
-  // can get without delaying the ref)
-  delayMs = juce::jlimit(0.0, 10.0, delayMs);
+      double tau = tau0 + m * step;
+      if (score > bestScore && std::abs(tau) <= maxLag) {
+        bestScore = score;
+        bestTau = tau;
+      }
+
+      for (int b = 0; b < numBins; ++b) {
+        float re = pRe[b] * dRe[b] - pIm[b] * dIm[b];
+        pIm[b] = pRe[b] * dIm[b] + pIm[b] * dRe[b];
+        pRe[b] = re;
+      }
+    }
+  }
 
-  return delayMs;
+  // Strength: how much of the band adds up in phase, 0..1
+  return {bestTau / sr * 1000.0,
+          juce::jlimit(0.0, 1.0, bestScore / totalMagnitude)};
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "AlignmentCache.h"
 #include "IRSlot.h"
 #include <JuceHeader.h>
 
@@ -8,12 +9,54 @@ public:
   AutoAligner(std::array<IRSlot, 4> &slots);
   ~AutoAligner() override;
 
-  void performAlignment(); // Triggers the background thread
+  // Analysis window over the start of each IR and the lag search range
+  // (both directions). The defaults follow the PRD; both go up to
+  // maxAnalysisMs now that the correlation runs in the frequency domain.
+  // peakCorrelation picks the broadband correlation peak; bandCoherence
+  // picks the delay that makes the blend sum loudest inside the band.
+  enum class Objective { peakCorrelation, bandCoherence };
+
+  struct Settings {
+    double windowMs = 5.0;
+    double searchRangeMs = 5.0;
+    // Whitened (GCC-PHAT) for a sharper peak; peakCorrelation only
+    bool phatWeighting = true;
+    Objective objective = Objective::bandCoherence;
+    double bandLoHz = 100.0, bandHiHz = 5000.0; // bandCoherence only
+  };
+  static constexpr double maxAnalysisMs = 500.0;
+
+  // Largest offset the slots' DelayMs parameter can hold; a slot that needs
+  // more is reported in outOfRange instead of being clamped
+  static constexpr double maxDelayMs = IRSlot::maxUserDelayMs;
+
+  // Message thread; picked up by the next performAlignment()
+  void setSettings(const Settings &newSettings);
+  Settings getSettings() const { return settings; }
+
+  // Where pairwise results persist between sessions
+  void setCacheFile(const juce::File &file) { cache.setFile(file); }
+
+  // Wakes the background thread; ignored while a run is in progress
+  void performAlignment();
 
   void run() override;
 
+  // Per-slot delays in ms, 0..maxDelayMs: the reference slot gets 0
   std::array<double, 4> results = {0.0, 0.0, 0.0, 0.0};
 
+  // Slots that would need a delay outside 0..maxDelayMs to line up; their
+  // result and confidence are 0 and their delay should be left alone
+  std::array<bool, 4> outOfRange = {false, false, false, false};
+
+  // Per-slot confidence in 0..1 once alignmentComplete() has fired: peak
+  // strength of the slot's pairwise correlations, discounted by how well
+  // they agree with the solution
+  double getConfidence(int slot) const { return confidence[(size_t)slot]; }
+
+  // Below this the slot strip flags the result as doubtful
+  static constexpr double lowConfidence = 0.25;
+
   // Listener interface to notify editor when alignment is done
   struct Listener {
     virtual ~Listener() = default;
@@ -27,8 +70,63 @@ private:
   std::array<IRSlot, 4> &slots;
   juce::ListenerList<Listener> listeners;
 
-  // Helper to calculate cross-correlation and find max lag
-  double findDelayOffset(const juce::AudioBuffer<float> &ref,
-                         const juce::AudioBuffer<float> &target,
-                         double sampleRate);
+  std::array<double, 4> confidence = {0.0, 0.0, 0.0, 0.0};
+
+  Settings settings;
+  Settings jobSettings; // Copied when a run starts, read by the thread
+  std::atomic<bool> busy{false};
+
+  // Pairwise correlations run here; the pool outlives single requests
+  static constexpr int maxPairs = 6; // 4 choose 2
+  static constexpr int jobPollMs = 50;
+  juce::ThreadPool pairPool;
+
+  // Pairs whose peak is this weak still keep the system solvable
+  static constexpr double minPairWeight = 1.0e-3;
+
+  struct Lag {
+    double ms = 0.0;       // How far the target lags the reference
+    double strength = 0.0; // Normalised peak height, 0..1
+  };
+
+  struct PairResult {
+    int first = 0, second = 0;
+    Lag lag;
+  };
+
+  // One run's inputs and outputs, shared with its pool jobs so that none
+  // of them outlives what it writes to
+  struct PairRun {
+    std::array<IRAsset::Ptr, 4> assets;
+    std::array<PairResult, maxPairs> pairs{};
+    std::atomic<int> remaining{0};
+    juce::WaitableEvent allDone;
+  };
+
+  // Known pairs are answered from here instead of being correlated again
+  AlignmentCache cache;
+
+  // Correlates all loaded pairs and solves for every slot's offset
+  void solveAlignment();
+
+  AlignmentCache::Key makeCacheKey(const IRAsset &ref,
+                                   const IRAsset &target) const;
+
+  // Generalised cross-correlation via FFT. Returns how far (in ms, signed,
+  // sub-sample) the target lags behind the reference, and how clear the
+  // peak was.
+  Lag findDelayOffset(const IRAsset &ref, const IRAsset &target);
+
+  // Band coherence objective over the cross spectrum conj(Ref) * Tgt.
+  // Overwrites the spectrum.
+  Lag findCoherentLag(std::complex<float> *cross, int fftSize,
+                      juce::dsp::FFT &fft, double sampleRate, int maxLag);
+
+  // Coarse peaks refined by the coherence objective, and the refinement
+  // grid per sample (numRefinedPeaks x (2 x subSampleSteps + 1) candidates)
+  static constexpr int numRefinedPeaks = 8;
+  static constexpr int subSampleSteps = 64;
+
+  // Part of every cache key; bump when a change alters the results
+  static constexpr int algorithmVersion = 1;
 };
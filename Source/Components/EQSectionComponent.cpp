@@ -11,6 +11,7 @@ EQSectionComponent::EQSectionComponent(FreeIRAudioProcessor &processor)
   setupKnob(trebleKnob, trebleLabel, "TrebleGainDb", trebleAttach, 0.0);
   setupKnob(airKnob, airLabel, "AirGainDb", airAttach, 0.0);
   setupKnob(outputKnob, outputLabel, "OutputGainDb", outputAttach, 0.0);
+  setupKnob(dryKnob, dryLabel, "DryMix", dryAttach, 0.0);
 }
 
 EQSectionComponent::~EQSectionComponent() {}
@@ -46,8 +47,8 @@ void EQSectionComponent::paint(juce::Graphics &g) {
   g.drawRoundedRectangle(bounds, 8.0f, 1.0f);
 
   // Mid group box styling
-  auto midGroupX = bounds.getWidth() * (4.0f / 9.0f);
-  auto midGroupW = bounds.getWidth() * (3.0f / 9.0f);
+  auto midGroupX = bounds.getWidth() * (4.0f / 10.0f);
+  auto midGroupW = bounds.getWidth() * (3.0f / 10.0f);
   auto midGroupRect = juce::Rectangle<float>(midGroupX + 4, 4, midGroupW - 8,
                                              bounds.getHeight() - 8);
 
@@ -67,7 +68,7 @@ void EQSectionComponent::paint(juce::Graphics &g) {
 void EQSectionComponent::resized() {
   auto area = getLocalBounds().reduced(8);
 
-  int numKnobs = 9;
+  int numKnobs = 10;
   auto knobW = (float)area.getWidth() / (float)numKnobs;
   int labelH = 14;
   int knobSize = juce::jmin((int)knobW - 4, area.getHeight() - labelH - 4);
@@ -84,6 +85,7 @@ void EQSectionComponent::resized() {
       {&midQKnob, &midQLabel},
 
       {&trebleKnob, &trebleLabel},   {&outputKnob, &outputLabel},
+      {&dryKnob, &dryLabel},
   };
 
   // Re-layout knobs
@@ -104,8 +106,8 @@ void EQSectionComponent::resized() {
     knobs[i].label->setBounds(r);
   }
 
-  // Knobs 7-8 (Right)
-  for (int i = 7; i < 9; ++i) {
+  // Knobs 7-9 (Right)
+  for (int i = 7; i < 10; ++i) {
     auto r = area.removeFromLeft((int)knobW);
     auto kR = r.removeFromTop(r.getHeight() - labelH);
     knobs[i].knob->setBounds(kR.withSizeKeepingCentre(knobSize, knobSize));
@@ -20,7 +20,7 @@ private:
   // EQ knobs
   juce::Slider loCutKnob, hiCutKnob, bassKnob, trebleKnob, airKnob;
   juce::Slider midGainKnob, midFreqKnob, midQKnob;
-  juce::Slider outputKnob;
+  juce::Slider outputKnob, dryKnob;
 
   juce::Label loCutLabel{{}, "Lo Cut"};
   juce::Label hiCutLabel{{}, "Hi Cut"};
@@ -31,6 +31,7 @@ private:
   juce::Label midFreqLabel{{}, "Freq"};
   juce::Label midQLabel{{}, "Q"};
   juce::Label outputLabel{{}, "Out"};
+  juce::Label dryLabel{{}, "Dry"};
 
   // APVTS attachments
   std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
@@ -51,6 +52,8 @@ private:
       midQAttach;
   std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
       outputAttach;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
+      dryAttach;
 
   void setupKnob(
       juce::Slider &knob, juce::Label &label, const juce::String &paramID,
@@ -63,6 +63,7 @@ IRBrowserComponent::IRBrowserComponent(FreeIRAudioProcessor &p)
                       auto result = chooser.getResult();
                       if (result.isDirectory()) {
                         favoriteFolders.add(result.getFullPathName());
+                        libraryIndex->watchFolder(result);
                         sidebarList.updateContent();
                         refreshFavorites();
                         savePersistentState();
@@ -89,6 +90,37 @@ IRBrowserComponent::IRBrowserComponent(FreeIRAudioProcessor &p)
   fileList.setMultipleSelectionEnabled(true);
   addAndMakeVisible(fileList);
 
+  searchBox.setTextToShowWhenEmpty("Search", juce::Colour(0xff888888));
+  searchBox.onTextChange = [this] { updateListQuery(); };
+  addAndMakeVisible(searchBox);
+
+  sortBox.addItem("Name", 1);
+  sortBox.addItem("Length", 2);
+  sortBox.addItem("Loudness", 3);
+  sortBox.addItem("Date", 4);
+  sortBox.setSelectedId(1, juce::dontSendNotification);
+  sortBox.onChange = [this] { updateListQuery(); };
+  addAndMakeVisible(sortBox);
+
+  auditionBox.addItem("Audition Off", 1);
+  for (int i = 0; i < FreeIRAudioProcessor::numSlots; ++i)
+    auditionBox.addItem("Audition Slot " + juce::String(i + 1), i + 2);
+  auditionBox.setSelectedId(1, juce::dontSendNotification);
+  auditionBox.onChange = [this] {
+    setAuditionSlot(auditionBox.getSelectedId() - 2);
+  };
+  addAndMakeVisible(auditionBox);
+
+  listQuery.onResult = [this](IRListQuery::Items items,
+                              std::vector<int> rows) {
+    shownItems = std::move(items);
+    shownRows = std::move(rows);
+    fileList.updateContent();
+    fileList.repaint();
+  };
+
+  libraryIndex->addChangeListener(this);
+
   // Load persistence
   loadPersistentState();
 
@@ -100,7 +132,11 @@ IRBrowserComponent::IRBrowserComponent(FreeIRAudioProcessor &p)
   }
 }
 
-IRBrowserComponent::~IRBrowserComponent() {}
+IRBrowserComponent::~IRBrowserComponent() {
+  libraryIndex->removeChangeListener(this);
+  if (proc.getAudition().getArmedSlot() >= 0)
+    proc.getAudition().revert();
+}
 
 void IRBrowserComponent::paint(juce::Graphics &g) {
   g.setColour(juce::Colour(0x0affffff));
@@ -122,22 +158,33 @@ void IRBrowserComponent::resized() {
   sidebarList.setBounds(sidebarArea);
 
   // File List Layout
-  irListLabel.setBounds(area.removeFromTop(24));
+  auto labelArea = area.removeFromTop(24);
+  auditionBox.setBounds(labelArea.removeFromRight(130));
+  irListLabel.setBounds(labelArea);
+  auto queryArea = area.removeFromTop(24);
+  sortBox.setBounds(queryArea.removeFromRight(90));
+  queryArea.removeFromRight(4);
+  searchBox.setBounds(queryArea);
+  area.removeFromTop(4);
   fileList.setBounds(area);
 }
 
 //==============================================================================
-int IRBrowserComponent::getNumRows() { return (int)currentFileList.size(); }
+int IRBrowserComponent::getNumRows() { return (int)shownRows.size(); }
+
+juce::File IRBrowserComponent::getRowFile(int row) const {
+  if (!juce::isPositiveAndBelow(row, (int)shownRows.size()))
+    return {};
+  return shownItems->items[(size_t)shownRows[(size_t)row]]->getFile();
+}
 
 juce::var IRBrowserComponent::getDragSourceDescription(
     const juce::SparseSet<int> &selectedRows) {
   juce::Array<juce::var> files;
   for (int i = 0; i < selectedRows.size(); ++i) {
-    if (isPositiveAndBelow(selectedRows[i], (int)currentFileList.size())) {
-      auto file = currentFileList[selectedRows[i]];
-      if (file.existsAsFile())
-        files.add(file.getFullPathName());
-    }
+    auto file = getRowFile(selectedRows[i]);
+    if (file.existsAsFile())
+      files.add(file.getFullPathName());
   }
   return files;
 }
@@ -149,19 +196,75 @@ void IRBrowserComponent::paintListBoxItem(int row, juce::Graphics &g, int width,
     g.fillRect(0, 0, width, height);
   }
 
-  if (row >= currentFileList.size())
+  if (!juce::isPositiveAndBelow(row, (int)shownRows.size()))
     return;
 
-  g.setColour(juce::Colours::white);
+  // Strings and thumbnails come ready-made from the index; painting a row
+  // neither formats text nor reads the file
+  const auto &entry = *shownItems->items[(size_t)shownRows[(size_t)row]];
+  auto area = juce::Rectangle<int>(width, height).reduced(4, 0);
+  auto detailsArea = area.removeFromRight(juce::jmin(150, width / 2));
+
+  if (width >= minThumbnailRowWidth && !entry.thumbnail.isEmpty()) {
+    auto spectrumArea = area.removeFromRight(spectrumWidth).reduced(0, 3);
+    area.removeFromRight(6);
+    auto waveformArea = area.removeFromRight(waveformWidth).reduced(0, 2);
+    area.removeFromRight(6);
+
+    g.setColour(juce::Colour(0xff6fa8dc));
+    drawWaveform(g, entry.thumbnail, waveformArea.toFloat());
+    g.setColour(juce::Colour(0xffe0a050));
+    drawSpectrum(g, entry.analysis.fingerprint, spectrumArea.toFloat());
+  }
+
   g.setFont(12.0f);
-  g.drawText(currentFileList[row].getFileName(), 4, 0, width - 4, height,
-             juce::Justification::centredLeft);
+  g.setColour(juce::Colours::white);
+  g.drawText(entry.name, area, juce::Justification::centredLeft);
+  g.setColour(juce::Colour(0xff888888));
+  g.drawText(entry.details, detailsArea, juce::Justification::centredRight);
+}
+
+void IRBrowserComponent::drawWaveform(juce::Graphics &g,
+                                      const IRThumbnail &thumbnail,
+                                      juce::Rectangle<float> area) {
+  // The finest pyramid level that still fits, one column per pixel or more
+  int level = 0;
+  while (level < IRThumbnail::numLevels - 1 &&
+         IRThumbnail::getNumColumns(level) > (int)area.getWidth())
+    ++level;
+
+  int numColumns = IRThumbnail::getNumColumns(level);
+  float columnWidth = area.getWidth() / (float)numColumns;
+  float centre = area.getCentreY(), halfHeight = area.getHeight() * 0.5f;
+  for (int c = 0; c < numColumns; ++c) {
+    auto range = thumbnail.getColumn(level, c);
+    float top = centre - range.getEnd() * halfHeight;
+    float bottom = centre - range.getStart() * halfHeight;
+    g.fillRect(area.getX() + c * columnWidth, top, columnWidth,
+               juce::jmax(1.0f, bottom - top));
+  }
+}
+
+void IRBrowserComponent::drawSpectrum(
+    juce::Graphics &g, const IRAnalysis::Fingerprint &fingerprint,
+    juce::Rectangle<float> area) {
+  auto yFor = [area](float levelDb) {
+    float normalised = juce::jlimit(-1.0f, 1.0f, levelDb / spectrumRangeDb);
+    return area.getCentreY() - normalised * area.getHeight() * 0.5f;
+  };
+
+  // Plain line segments: unlike a Path they need no allocation
+  float step = area.getWidth() / (float)(fingerprint.size() - 1);
+  for (size_t band = 1; band < fingerprint.size(); ++band)
+    g.drawLine(area.getX() + (float)(band - 1) * step,
+               yFor(fingerprint[band - 1]),
+               area.getX() + (float)band * step, yFor(fingerprint[band]));
 }
 
 void IRBrowserComponent::listBoxItemClicked(int row,
                                             const juce::MouseEvent &e) {
   if (e.mods.isPopupMenu()) {
-    if (row >= 0 && row < currentFileList.size()) {
+    if (juce::isPositiveAndBelow(row, getNumRows())) {
       juce::PopupMenu m;
       m.addItem(1, "Add to Playlist");
       m.addSeparator();
@@ -169,33 +272,90 @@ void IRBrowserComponent::listBoxItemClicked(int row,
       m.addItem(3, "Load into Slot B");
       m.addItem(4, "Load into Slot C");
       m.addItem(5, "Load into Slot D");
+      m.addSeparator();
+      m.addItem(6, "Find Similar");
 
-      m.showMenuAsync(juce::PopupMenu::Options(), [this, row](int id) {
+      // Rows may be re-sorted before the menu returns, so capture files
+      auto file = getRowFile(row);
+      std::vector<juce::File> selectedFiles;
+      auto selected = fileList.getSelectedRows();
+      for (int i = 0; i < selected.size(); ++i)
+        selectedFiles.push_back(getRowFile(selected[i]));
+
+      m.showMenuAsync(juce::PopupMenu::Options(), [this, file,
+                                                   selectedFiles](int id) {
         if (id == 1) {
-          auto selected = fileList.getSelectedRows();
-          if (selected.size() > 0) {
-            for (int i = 0; i < selected.size(); ++i) {
-              if (isPositiveAndBelow(selected[i], (int)currentFileList.size()))
-                addToPlaylist(currentFileList[selected[i]]);
-            }
+          if (!selectedFiles.empty()) {
+            for (auto &selectedFile : selectedFiles)
+              addToPlaylist(selectedFile);
           } else {
-            addToPlaylist(currentFileList[row]);
+            addToPlaylist(file);
           }
         } else if (id >= 2 && id <= 5) {
           int slotIdx = id - 2;
           if (onLoadIRToSlot)
-            onLoadIRToSlot(currentFileList[row], slotIdx);
+            onLoadIRToSlot(file, slotIdx);
+        } else if (id == 6) {
+          showSimilarTo(file);
         }
       });
     }
   }
 }
 
+void IRBrowserComponent::selectedRowsChanged(int lastRowSelected) {
+  if (proc.getAudition().getArmedSlot() >= 0)
+    auditionRow(lastRowSelected);
+}
+
+void IRBrowserComponent::returnKeyPressed(int) {
+  if (proc.getAudition().getArmedSlot() < 0)
+    return;
+
+  proc.getAudition().commit();
+  auditionBox.setSelectedId(1, juce::dontSendNotification);
+}
+
+bool IRBrowserComponent::keyPressed(const juce::KeyPress &key) {
+  if (key == juce::KeyPress::escapeKey &&
+      proc.getAudition().getArmedSlot() >= 0) {
+    auditionBox.setSelectedId(1); // Reverts
+    return true;
+  }
+  return false;
+}
+
+void IRBrowserComponent::setAuditionSlot(int slotIndex) {
+  auto &audition = proc.getAudition();
+  if (slotIndex < 0) {
+    audition.revert();
+    return;
+  }
+
+  audition.arm(slotIndex);
+  auditionRow(fileList.getSelectedRow());
+  fileList.grabKeyboardFocus();
+}
+
+void IRBrowserComponent::auditionRow(int row) {
+  if (!juce::isPositiveAndBelow(row, getNumRows()))
+    return;
+
+  // The selected row first, then its neighbours in display order, which
+  // the audition engine loads ahead of the arrow keys
+  std::vector<juce::File> files{getRowFile(row)};
+  if (row + 1 < getNumRows())
+    files.push_back(getRowFile(row + 1));
+  if (row > 0)
+    files.push_back(getRowFile(row - 1));
+  proc.getAudition().audition(std::move(files));
+}
+
 void IRBrowserComponent::listBoxItemDoubleClicked(int row,
                                                   const juce::MouseEvent &) {
-  if (row >= 0 && row < currentFileList.size()) {
+  if (juce::isPositiveAndBelow(row, getNumRows())) {
     if (onLoadIR)
-      onLoadIR(currentFileList[row]);
+      onLoadIR(getRowFile(row));
   }
 }
 
@@ -203,35 +363,90 @@ void IRBrowserComponent::listBoxItemDoubleClicked(int row,
 void IRBrowserComponent::scanDirectory(const juce::File &dir) {
   currentDirectory = dir;
   isShowingPlaylist = false;
-  currentFileList.clear();
-
-  if (dir.isDirectory()) {
-    auto files =
-        dir.findChildFiles(juce::File::findFiles, false, "*.wav;*.aif;*.aiff");
-    for (auto &f : files)
-      currentFileList.push_back(f);
-  }
+  isShowingSimilar = false;
+  // Listed from the index (subfolders included), which follows the folder's
+  // changes and tells us when the list needs refreshing
+  setListItems(
+      IRListQuery::makeFolderItems(libraryIndex->getSnapshot(), dir));
+  libraryIndex->watchFolder(dir);
 
   irListLabel.setText(dir.getFileName().toUpperCase(),
                       juce::dontSendNotification);
-  fileList.updateContent();
 
   // Note: we don't save selection, just the favorite folders
 }
 
+void IRBrowserComponent::changeListenerCallback(juce::ChangeBroadcaster *) {
+  if (isShowingPlaylist || currentDirectory == juce::File())
+    return;
+
+  setListItems(IRListQuery::makeFolderItems(libraryIndex->getSnapshot(),
+                                            currentDirectory));
+}
+
+void IRBrowserComponent::setListItems(IRListQuery::Items items) {
+  listItems = std::move(items);
+  updateListQuery();
+}
+
+void IRBrowserComponent::updateListQuery() {
+  if (listItems == nullptr)
+    return;
+
+  // Ranked results keep their rank unless a search reorders them
+  auto order = IRListQuery::SortOrder::listed;
+  if (!isShowingSimilar) {
+    switch (sortBox.getSelectedId()) {
+    case 2:
+      order = IRListQuery::SortOrder::length;
+      break;
+    case 3:
+      order = IRListQuery::SortOrder::loudness;
+      break;
+    case 4:
+      order = IRListQuery::SortOrder::date;
+      break;
+    default:
+      order = IRListQuery::SortOrder::name;
+      break;
+    }
+  }
+  listQuery.request(listItems, searchBox.getText(), order);
+}
+
 void IRBrowserComponent::showPlaylist() {
   isShowingPlaylist = true;
+  isShowingSimilar = false;
   currentDirectory = juce::File();
   // refresh playlist from paths
-  currentFileList.clear();
+  std::vector<juce::File> files;
   for (auto &path : playlistFiles) {
     juce::File f(path);
     if (f.existsAsFile())
-      currentFileList.push_back(f);
+      files.push_back(f);
   }
+  setListItems(IRListQuery::makeItems(libraryIndex->getSnapshot(), files));
 
   irListLabel.setText("MY PLAYLIST", juce::dontSendNotification);
-  fileList.updateContent();
+}
+
+void IRBrowserComponent::showSimilarTo(const juce::File &file) {
+  IRAnalysis analysis;
+  if (!libraryIndex->findAnalysis(file, analysis))
+    return;
+
+  // A fixed result list: neither a folder nor the playlist
+  isShowingPlaylist = false;
+  isShowingSimilar = true;
+  currentDirectory = juce::File();
+  auto files =
+      libraryIndex->findSimilar(analysis.fingerprint, maxSimilarResults, file);
+  files.insert(files.begin(), file);
+  setListItems(IRListQuery::makeItems(libraryIndex->getSnapshot(), files));
+
+  irListLabel.setText("SIMILAR TO " +
+                          file.getFileNameWithoutExtension().toUpperCase(),
+                      juce::dontSendNotification);
 }
 
 void IRBrowserComponent::addToPlaylist(const juce::File &file) {
@@ -261,4 +476,7 @@ void IRBrowserComponent::loadPersistentState() {
   proc.getPresetManager().loadGlobalSettings(favoriteFolders, playlistFiles,
                                              lastPreset);
   sidebarList.updateContent();
+
+  for (auto &folder : favoriteFolders)
+    libraryIndex->watchFolder(juce::File(folder));
 }
@@ -1,7 +1,11 @@
+#include "../IRLibraryIndex.h"
+#include "../IRListQuery.h"
 #include "../PluginProcessor.h"
 
 //==============================================================================
-class IRBrowserComponent : public juce::Component, public juce::ListBoxModel {
+class IRBrowserComponent : public juce::Component,
+                           public juce::ListBoxModel,
+                           private juce::ChangeListener {
 public:
   IRBrowserComponent(FreeIRAudioProcessor &p);
   ~IRBrowserComponent() override;
@@ -17,6 +21,10 @@ public:
   void listBoxItemDoubleClicked(int row, const juce::MouseEvent &) override;
   juce::var
   getDragSourceDescription(const juce::SparseSet<int> &selectedRows) override;
+  void selectedRowsChanged(int lastRowSelected) override;
+  void returnKeyPressed(int lastRowSelected) override;
+
+  bool keyPressed(const juce::KeyPress &key) override;
 
   std::function<void(juce::File)> onLoadIR;
   std::function<void(juce::File, int)> onLoadIRToSlot;
@@ -24,17 +32,52 @@ public:
 private:
   FreeIRAudioProcessor &proc;
 
+  // Folder listings come from here; it rescans in the background
+  juce::SharedResourcePointer<IRLibraryIndex> libraryIndex;
+  void changeListenerCallback(juce::ChangeBroadcaster *) override;
+
   // Data
   juce::StringArray
       favoriteFolders; // Change to StringArray for easier persistence
   juce::StringArray
       playlistFiles; // Change to StringArray for easier persistence
 
-  std::vector<juce::File>
-      currentFileList;         // Files in currently selected folder OR playlist
   juce::File currentDirectory; // If valid, we are browsing a folder. If
                                // invalid, maybe playlist?
   bool isShowingPlaylist = false;
+  bool isShowingSimilar = false;
+
+  // Rows of the current folder, playlist or search result. The worker
+  // filters and sorts listItems; painting only reads what it sent back.
+  IRListQuery listQuery;
+  IRListQuery::Items listItems; // Latest list handed to the worker
+  IRListQuery::Items shownItems;
+  std::vector<int> shownRows;
+
+  void setListItems(IRListQuery::Items items);
+  void updateListQuery();
+  juce::File getRowFile(int row) const;
+
+  // Row thumbnails, drawn from the index entry alone: no file access
+  static void drawWaveform(juce::Graphics &g, const IRThumbnail &thumbnail,
+                           juce::Rectangle<float> area);
+  static void drawSpectrum(juce::Graphics &g,
+                           const IRAnalysis::Fingerprint &fingerprint,
+                           juce::Rectangle<float> area);
+
+  // Thumbnails appear once a row is at least this wide
+  static constexpr int minThumbnailRowWidth = 360;
+  static constexpr int waveformWidth = 64;
+  static constexpr int spectrumWidth = 40;
+  static constexpr float spectrumRangeDb = 30.0f; // Either side of the mean
+
+  // Audition: while a slot is armed the selected row plays through it;
+  // Return keeps the IR, Escape goes back to the slot's own
+  void setAuditionSlot(int slotIndex);
+  void auditionRow(int row);
+
+  // "Find Similar" lists the chosen IR followed by this many neighbours
+  static constexpr int maxSimilarResults = 100;
 
   // UI
   juce::Label placesLabel{{}, "PLACES"};
@@ -59,12 +102,16 @@ private:
   juce::ListBox sidebarList;
 
   juce::Label irListLabel{{}, "IMPULSE RESPONSES"};
+  juce::TextEditor searchBox;
+  juce::ComboBox sortBox;
+  juce::ComboBox auditionBox;
   juce::ListBox fileList; // This component handles the Main List visuals
 
   // Helpers
   // Helpers
   void scanDirectory(const juce::File &dir);
   void showPlaylist();
+  void showSimilarTo(const juce::File &file);
   void addToPlaylist(const juce::File &file);
   void refreshFavorites(); // Updates listbox
 
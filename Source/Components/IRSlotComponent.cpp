@@ -112,6 +112,31 @@ IRSlotComponent::IRSlotComponent(FreeIRAudioProcessor &processor, int slotIndex)
   panLabel.setColour(juce::Label::textColourId, juce::Colours::grey);
   addAndMakeVisible(panLabel);
 
+  // Tone: Lo Cut / Tilt / Hi Cut
+  auto setUpToneKnob = [this, &prefix](juce::Slider &knob, juce::Label &label,
+                                       const juce::String &text,
+                                       const juce::String &paramID,
+                                       const juce::String &suffix) {
+    knob.setSliderStyle(juce::Slider::RotaryVerticalDrag);
+    knob.setTextBoxStyle(juce::Slider::NoTextBox, false, 0, 0);
+    knob.setPopupDisplayEnabled(true, true, this);
+    knob.setTextValueSuffix(suffix);
+    addAndMakeVisible(knob);
+
+    label.setText(text, juce::dontSendNotification);
+    label.setFont(10.0f);
+    label.setJustificationType(juce::Justification::centred);
+    label.setColour(juce::Label::textColourId, juce::Colours::grey);
+    addAndMakeVisible(label);
+
+    return std::make_unique<
+        juce::AudioProcessorValueTreeState::SliderAttachment>(
+        proc.getAPVTS(), prefix + paramID, knob);
+  };
+  loCutAttach = setUpToneKnob(loCutKnob, loCutLabel, "Lo", "LoCutHz", " Hz");
+  tiltAttach = setUpToneKnob(tiltKnob, tiltLabel, "Tilt", "TiltDb", " dB");
+  hiCutAttach = setUpToneKnob(hiCutKnob, hiCutLabel, "Hi", "HiCutHz", " Hz");
+
   // Fader (Vol)
   fader.setSliderStyle(juce::Slider::LinearVertical);
   fader.setTextBoxStyle(juce::Slider::TextBoxBelow, false, 50, 14);
@@ -200,6 +225,23 @@ void IRSlotComponent::resized() {
   delayKnob.setBounds(delayArea.removeFromTop(46).reduced(4));
   delayLabel.setBounds(delayArea);
 
+  // Tone Row
+  auto toneRow = area.removeFromTop(50);
+  int toneWid = area.getWidth() / 3;
+
+  auto loCutArea = toneRow.removeFromLeft(toneWid);
+  auto hiCutArea = toneRow.removeFromRight(toneWid);
+  auto tiltArea = toneRow;
+
+  loCutKnob.setBounds(loCutArea.removeFromTop(36).reduced(3));
+  loCutLabel.setBounds(loCutArea);
+
+  tiltKnob.setBounds(tiltArea.removeFromTop(36).reduced(3));
+  tiltLabel.setBounds(tiltArea);
+
+  hiCutKnob.setBounds(hiCutArea.removeFromTop(36).reduced(3));
+  hiCutLabel.setBounds(hiCutArea);
+
   area.removeFromTop(12);
 
   // Bottom: Mute/Solo
@@ -219,7 +261,7 @@ void IRSlotComponent::resized() {
 
 void IRSlotComponent::updateSlotDisplay() {
   auto &slot = proc.getIRSlot(slotID);
-  if (slot.isLoaded()) {
+  if (!slot.isEmpty()) {
     loadButton.setButtonText(slot.getSlotName());
     // Highlight logic could go here
   } else {
@@ -232,6 +274,27 @@ void IRSlotComponent::setDelayEnabled(bool enabled) {
   delayKnob.setAlpha(enabled ? 1.0f : 0.5f);
 }
 
+void IRSlotComponent::showAlignmentResult(double confidence,
+                                          bool outOfRange) {
+  bool doubtful = confidence >= 0.0 &&
+                  confidence < AutoAligner::lowConfidence && !outOfRange;
+  delayLabel.setText(outOfRange ? "Delay !" : doubtful ? "Delay ?" : "Delay",
+                     juce::dontSendNotification);
+  delayLabel.setColour(juce::Label::textColourId,
+                       outOfRange || doubtful ? juce::Colours::orange
+                                              : juce::Colours::grey);
+
+  juce::String tip;
+  if (outOfRange)
+    tip = "Auto Align: this IR is more than " +
+          juce::String((int)AutoAligner::maxDelayMs) +
+          " ms away from the others, so its delay was kept";
+  else if (confidence >= 0.0)
+    tip = "Auto Align confidence: " +
+          juce::String(juce::roundToInt(confidence * 100.0)) + "%";
+  delayLabel.setTooltip(tip);
+}
+
 bool IRSlotComponent::isInterestedInDragSource(
     const juce::DragAndDropTarget::SourceDetails &dragSourceDetails) {
   return dragSourceDetails.description.isArray();
@@ -22,6 +22,10 @@ public:
 
   void setDelayEnabled(bool enabled);
 
+  // Auto Align's confidence for this slot, flagging a doubtful result or
+  // one the delay knob could not reach; negative clears it
+  void showAlignmentResult(double confidence, bool outOfRange);
+
   // Slider::Listener — fires when delay knob moves
   // Slider::Listener removed
 
@@ -48,6 +52,12 @@ private:
   std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
       panAttach;
 
+  // Per-slot tone
+  juce::Slider loCutKnob, tiltKnob, hiCutKnob;
+  juce::Label loCutLabel, tiltLabel, hiCutLabel;
+  std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
+      loCutAttach, tiltAttach, hiCutAttach;
+
   // Fader & Mute/Solo
   juce::Slider fader;
   std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment>
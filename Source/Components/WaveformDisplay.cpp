@@ -2,14 +2,11 @@
 
 WaveformDisplay::WaveformDisplay() { startTimerHz(30); }
 
-void WaveformDisplay::setIRData(int slotIndex,
-                                const juce::AudioBuffer<float> *buffer,
-                                double sampleRate, double alignOffsetMs) {
+void WaveformDisplay::setIRData(int slotIndex, IRAsset::Ptr asset,
+                                double alignOffsetMs) {
   if (slotIndex < 0 || slotIndex >= 4)
     return;
-  slotData[(size_t)slotIndex] = {buffer, sampleRate, alignOffsetMs,
-                                 buffer != nullptr &&
-                                     buffer->getNumSamples() > 0};
+  slotData[(size_t)slotIndex] = {std::move(asset), alignOffsetMs};
   needsRepaint = true;
 }
 
@@ -85,11 +82,12 @@ void WaveformDisplay::paint(juce::Graphics &g) {
   };
 
   for (int s = 3; s >= 0; --s) {
-    if (!slotData[(size_t)s].valid || slotData[(size_t)s].buffer == nullptr)
+    const auto &asset = slotData[(size_t)s].asset;
+    if (asset == nullptr)
       continue;
 
-    const auto &buf = *slotData[(size_t)s].buffer;
-    double sr = slotData[(size_t)s].sampleRate;
+    const auto &buf = asset->getBuffer();
+    double sr = asset->getSampleRate();
     double offsetMs = slotData[(size_t)s].alignOffsetMs;
 
     if (buf.getNumSamples() == 0 || sr <= 0.0)
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "../IRAsset.h"
 #include <JuceHeader.h>
 
 //==============================================================================
@@ -9,8 +10,7 @@ class WaveformDisplay : public juce::Component, public juce::Timer {
 public:
   WaveformDisplay();
 
-  void setIRData(int slotIndex, const juce::AudioBuffer<float> *buffer,
-                 double sampleRate, double alignOffsetMs);
+  void setIRData(int slotIndex, IRAsset::Ptr asset, double alignOffsetMs);
   void clearSlot(int slotIndex);
   void refresh();
 
@@ -20,10 +20,8 @@ public:
 
 private:
   struct SlotData {
-    const juce::AudioBuffer<float> *buffer = nullptr;
-    double sampleRate = 48000.0;
+    IRAsset::Ptr asset; // Held so the samples outlive a reload
     double alignOffsetMs = 0.0;
-    bool valid = false;
   };
 
   std::array<SlotData, 4> slotData;
@@ -0,0 +1,210 @@
+#include "EQKernelBaker.h"
+
+EQKernelBaker::EQKernelBaker(std::array<IRSlot, 4> &s,
+                             juce::AudioProcessorValueTreeState &apvts)
+    : juce::Thread("FreeIR EQ Baker"), slots(s), renderEQ(apvts) {}
+
+EQKernelBaker::~EQKernelBaker() {
+  stopTimer();
+  stopThread(4000);
+}
+
+void EQKernelBaker::prepare(double hostSampleRate, int maxBlockSize) {
+  sampleRate = hostSampleRate;
+  blockSize = juce::jmax(1, maxBlockSize);
+}
+
+void EQKernelBaker::setEnabled(bool shouldBeEnabled) {
+  enabled = shouldBeEnabled;
+
+  if (shouldBeEnabled) {
+    if (!isThreadRunning())
+      startThread(juce::Thread::Priority::low);
+    startTimerHz(10);
+  } else {
+    stopTimer();
+  }
+}
+
+bool EQKernelBaker::isBakedCurrent() const {
+  if (!enabled)
+    return false;
+
+  auto baked = bakedHash.load();
+  return baked != 0 &&
+         baked == computeStateHash(renderEQ.getParameterSettings());
+}
+
+void EQKernelBaker::confirmSwap() {
+  bakedHash = queuedHash.load();
+  swapPending = false;
+  busy = false;
+}
+
+void EQKernelBaker::abandonSwap() {
+  swapPending = false;
+  busy = false;
+}
+
+uint64_t
+EQKernelBaker::computeStateHash(const EQProcessor::Settings &settings) const {
+  // FNV-1a
+  uint64_t hash = 14695981039346656037ull;
+  auto mix = [&hash](const void *data, size_t size) {
+    auto *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash ^= bytes[i];
+      hash *= 1099511628211ull;
+    }
+  };
+
+  mix(&settings, sizeof(settings));
+  double rate = sampleRate;
+  mix(&rate, sizeof(rate));
+  for (auto &slot : slots) {
+    auto generation = slot.getIRGeneration();
+    mix(&generation, sizeof(generation));
+  }
+  return hash;
+}
+
+//==============================================================================
+void EQKernelBaker::timerCallback() {
+  if (!enabled || busy || sampleRate <= 0.0)
+    return;
+
+  auto settings = renderEQ.getParameterSettings();
+  auto hash = computeStateHash(settings);
+  auto now = juce::Time::getMillisecondCounter();
+
+  // Only bake once the EQ and the IRs have stopped moving
+  if (hash != lastSeenHash) {
+    lastSeenHash = hash;
+    lastChangeMs = now;
+    return;
+  }
+  if (hash == bakedHash || now - lastChangeMs < settleMs)
+    return;
+
+  job.settings = settings;
+  job.hostRate = sampleRate;
+  job.hash = hash;
+  for (size_t i = 0; i < slots.size(); ++i) {
+    job.irs[i] = slots[i].getAsset();
+    job.gains[i] = job.irs[i] != nullptr
+                       ? slots[i].getKernelGain(*job.irs[i], sampleRate)
+                       : 1.0f;
+  }
+
+  busy = true;
+  notify();
+}
+
+void EQKernelBaker::run() {
+  while (!threadShouldExit()) {
+    wait(-1);
+    if (threadShouldExit() || !busy || swapPending)
+      continue;
+
+    juce::dsp::ProcessSpec spec{job.hostRate, (juce::uint32)blockSize, 2};
+    renderEQ.prepare(spec);
+    renderEQ.setFixedSettings(job.settings);
+
+    for (size_t i = 0; i < slots.size() && !threadShouldExit(); ++i) {
+      if (job.irs[i] == nullptr || job.irs[i]->getBuffer().getNumSamples() == 0)
+        continue;
+
+      renderEQ.reset();
+      auto kernel = bakeKernel(*job.irs[i], job.gains[i]);
+
+      // One sample longer than the kernel it replaces if need be, so the
+      // audio thread can tell when the swap has happened
+      int length = kernel.getNumSamples();
+      if (length == slots[i].getBakedKernelSize())
+        kernel.setSize(2, length + 1, true, true);
+      slots[i].loadBakedKernel(std::move(kernel), job.hostRate);
+    }
+    job.irs.fill(nullptr); // Let replaced IRs go
+
+    // The audio thread publishes the hash once it hears the new kernels
+    if (threadShouldExit()) {
+      busy = false;
+    } else {
+      queuedHash = job.hash;
+      swapPending = true;
+    }
+  }
+}
+
+juce::AudioBuffer<float> EQKernelBaker::bakeKernel(const IRAsset &asset,
+                                                   float gain) {
+  const auto &ir = asset.getBuffer();
+  double irRate = asset.getSampleRate();
+
+  // 1. Channels and trim, as Convolution::Stereo::yes / Trim::yes
+  int numChannels = juce::jlimit(1, 2, ir.getNumChannels());
+  int numSamples = ir.getNumSamples();
+  const float threshold = juce::Decibels::decibelsToGain(-80.0f);
+
+  int start = numSamples, endTrim = numSamples;
+  for (int ch = 0; ch < numChannels; ++ch) {
+    auto *data = ir.getReadPointer(ch);
+    int first = 0;
+    while (first < numSamples && std::abs(data[first]) < threshold)
+      ++first;
+    int last = 0;
+    while (last < numSamples &&
+           std::abs(data[numSamples - 1 - last]) < threshold)
+      ++last;
+    start = juce::jmin(start, first);
+    endTrim = juce::jmin(endTrim, last);
+  }
+
+  juce::AudioBuffer<float> trimmed;
+  if (start == numSamples) {
+    trimmed.setSize(numChannels, 1);
+    trimmed.clear();
+  } else {
+    int length = juce::jmax(1, numSamples - (start + endTrim));
+    trimmed.setSize(numChannels, length);
+    for (int ch = 0; ch < numChannels; ++ch)
+      trimmed.copyFrom(ch, 0, ir, ch, start, length);
+  }
+
+  // 2. Resample to the host rate the same way the engine does
+  double hostRate = job.hostRate;
+  juce::AudioBuffer<float> resampled;
+  if (irRate == hostRate) {
+    resampled = std::move(trimmed);
+  } else {
+    double ratio = irRate / hostRate;
+    int finalSize = juce::roundToInt(
+        juce::jmax(1.0, trimmed.getNumSamples() / ratio));
+    juce::MemoryAudioSource memorySource(trimmed, false);
+    juce::ResamplingAudioSource resampler(&memorySource, false, numChannels);
+    resampler.setResamplingRatio(ratio);
+    resampler.prepareToPlay(finalSize, irRate);
+    resampled.setSize(numChannels, finalSize);
+    resampler.getNextAudioBlock({&resampled, 0, finalSize});
+  }
+
+  // 3. The live engine's gain, so both engines play at the same level
+  resampled.applyGain(gain);
+
+  // 4. Run the EQ over the kernel plus room for it to ring out
+  int tail = (int)(EQProcessor::ringOutSeconds * hostRate);
+  juce::AudioBuffer<float> kernel(2, resampled.getNumSamples() + tail);
+  kernel.clear();
+  for (int ch = 0; ch < 2; ++ch)
+    kernel.copyFrom(ch, 0, resampled, juce::jmin(ch, numChannels - 1), 0,
+                    resampled.getNumSamples());
+
+  for (int pos = 0; pos < kernel.getNumSamples(); pos += blockSize) {
+    int n = juce::jmin(blockSize, kernel.getNumSamples() - pos);
+    juce::AudioBuffer<float> block(kernel.getArrayOfWritePointers(), 2, pos,
+                                   n);
+    renderEQ.process(block);
+  }
+
+  return kernel;
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include "EQProcessor.h"
+#include "IRSlot.h"
+#include <JuceHeader.h>
+
+//==============================================================================
+// EQKernelBaker: folds the master EQ into each slot's convolution kernel.
+//
+// The slot IRs, the sum and the EQ form one LTI system, so while the EQ sits
+// still it can be rendered into the kernels once instead of being filtered
+// per sample. A message-thread timer waits for the EQ and the loaded IRs to
+// settle, then a background thread prepares each IR exactly as the live
+// engine does (trim, resample, kernel gain), runs it through an offline
+// EQProcessor at the host rate and hands it to the slot's baked engine.
+//
+// A bake only becomes current once the audio thread has seen the convolvers
+// swap it in and calls confirmSwap(); until then the next one waits. The
+// audio thread only switches over while isBakedCurrent() holds.
+//==============================================================================
+class EQKernelBaker : private juce::Thread, private juce::Timer {
+public:
+  EQKernelBaker(std::array<IRSlot, 4> &slots,
+                juce::AudioProcessorValueTreeState &apvts);
+  ~EQKernelBaker() override;
+
+  // Message thread
+  void prepare(double hostSampleRate, int maxBlockSize);
+  void setEnabled(bool shouldBeEnabled);
+  bool isEnabled() const { return enabled; }
+
+  // Audio thread: the baked kernels match the current EQ settings and IRs
+  bool isBakedCurrent() const;
+
+  // Audio thread: a finished bake has been handed to the slots and waits
+  // for their convolvers to pick it up
+  bool isSwapPending() const { return swapPending; }
+
+  // Audio thread: the pending bake is being heard and becomes current, or
+  // never showed up (the engines were rebuilt) and is baked again
+  void confirmSwap();
+  void abandonSwap();
+
+private:
+  void timerCallback() override;
+  void run() override;
+
+  // Hash of the EQ settings, host rate and every slot's IR generation
+  uint64_t computeStateHash(const EQProcessor::Settings &settings) const;
+
+  juce::AudioBuffer<float> bakeKernel(const IRAsset &asset, float gain);
+
+  std::array<IRSlot, 4> &slots;
+
+  // Renders on the baker thread; its parameter reads are safe anywhere
+  EQProcessor renderEQ;
+
+  // Written by the timer while the thread is idle, read by the thread
+  struct Job {
+    EQProcessor::Settings settings;
+    std::array<IRAsset::Ptr, 4> irs; // Snapshots, no copies
+    std::array<float, 4> gains{};    // IRSlot::getKernelGain() of each
+    double hostRate = 48000.0;
+    uint64_t hash = 0;
+  };
+  Job job;
+
+  std::atomic<bool> enabled{false};
+  std::atomic<bool> busy{false}; // From the timer's job until its swap
+  std::atomic<bool> swapPending{false};
+  std::atomic<uint64_t> queuedHash{0};
+  std::atomic<uint64_t> bakedHash{0};
+  std::atomic<double> sampleRate{0.0};
+  int blockSize = 512;
+
+  // Message thread: the state must hold still this long before a bake
+  uint64_t lastSeenHash = 0;
+  juce::uint32 lastChangeMs = 0;
+  static constexpr juce::uint32 settleMs = 300;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(EQKernelBaker)
+};
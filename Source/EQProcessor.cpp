@@ -1,7 +1,9 @@
 #include "EQProcessor.h"
 
 EQProcessor::EQProcessor(juce::AudioProcessorValueTreeState &state)
-    : apvts(state) {}
+    : apvts(state) {
+  cacheParameterPointers();
+}
 
 void EQProcessor::cacheParameterPointers() {
   loCutParam = apvts.getRawParameterValue("LoCutHz");
@@ -16,149 +18,345 @@ void EQProcessor::cacheParameterPointers() {
 
 void EQProcessor::prepare(const juce::dsp::ProcessSpec &spec) {
   sampleRate = spec.sampleRate;
+  interleaved.resize((size_t)spec.maximumBlockSize);
+  reset();
 
-  juce::dsp::ProcessSpec monoSpec;
-  monoSpec.sampleRate = spec.sampleRate;
-  monoSpec.maximumBlockSize = spec.maximumBlockSize;
-  monoSpec.numChannels = 1;
-
-  loCutFilterL.prepare(monoSpec);
-  loCutFilterR.prepare(monoSpec);
-  bassFilterL.prepare(monoSpec);
-  bassFilterR.prepare(monoSpec);
-  midFilterL.prepare(monoSpec);
-  midFilterR.prepare(monoSpec);
-  trebleFilterL.prepare(monoSpec);
-  trebleFilterR.prepare(monoSpec);
-  airFilterL.prepare(monoSpec);
-  airFilterR.prepare(monoSpec);
-  hiCutFilterL.prepare(monoSpec);
-  hiCutFilterR.prepare(monoSpec);
-
-  cacheParameterPointers();
+  for (auto *smoother : {&loCutHz, &midFreqHz, &midQ, &hiCutHz})
+    smoother->reset(sampleRate, smoothingSeconds);
+  for (auto *smoother : {&bassDb, &midGainDb, &trebleDb, &airDb})
+    smoother->reset(sampleRate, smoothingSeconds);
 
-  // Force initial coefficient calculation
-  prevLoCut = -1.0f;
-  prevBass = -999.0f;
-  prevMidFreq = -1.0f;
-  prevMidQ = -1.0f;
-  prevMidGain = -999.0f;
-  prevTreble = -999.0f;
-  prevAir = -999.0f;
-  prevHiCut = -1.0f;
-  updateParametersIfNeeded();
+  // Force initial coefficient calculation, without a glide
+  smoothersInitialised = false;
+  updateTargets();
 }
 
 void EQProcessor::reset() {
-  loCutFilterL.reset();
-  loCutFilterR.reset();
-  bassFilterL.reset();
-  bassFilterR.reset();
-  midFilterL.reset();
-  midFilterR.reset();
-  trebleFilterL.reset();
-  trebleFilterR.reset();
-  airFilterL.reset();
-  airFilterR.reset();
-  hiCutFilterL.reset();
-  hiCutFilterR.reset();
+  for (auto &section : sections) {
+    section.s1 = Register(0.0f);
+    section.s2 = Register(0.0f);
+  }
 }
 
 void EQProcessor::process(juce::AudioBuffer<float> &buffer) {
-  updateParametersIfNeeded();
+  updateTargets();
 
   int numSamples = buffer.getNumSamples();
-  int numChannels = buffer.getNumChannels();
+  int numChannels = juce::jmin(buffer.getNumChannels(), 2);
+  int chunkSize = (int)interleaved.size();
+  if (numChannels == 0 || chunkSize == 0)
+    return;
 
-  if (numChannels > 0) {
-    auto *dataL = buffer.getWritePointer(0);
-    for (int i = 0; i < numSamples; ++i) {
-      float s = dataL[i];
-      s = loCutFilterL.processSample(s);
-      s = bassFilterL.processSample(s);
-      s = midFilterL.processSample(s);
-      s = trebleFilterL.processSample(s);
-      s = airFilterL.processSample(s);
-      s = hiCutFilterL.processSample(s);
-      dataL[i] = s;
+  // Whole chunks when settled; short sub-blocks while something glides
+  for (int pos = 0; pos < numSamples;) {
+    int n = juce::jmin(chunkSize, numSamples - pos);
+    if (isSmoothing()) {
+      n = juce::jmin(n, subBlockSize);
+      advanceSmoothing(n);
     }
+
+    if (cascadeLength > 0)
+      processChunk(buffer, numChannels, pos, n);
+    pos += n;
   }
+}
+
+void EQProcessor::processChunk(juce::AudioBuffer<float> &buffer,
+                               int numChannels, int start, int numSamples) {
+  // Interleave L/R into lanes 0/1; the spare lanes stay silent
+  auto *lanes = reinterpret_cast<float *>(interleaved.data());
+  const float *inL = buffer.getReadPointer(0, start);
+  const float *inR = buffer.getReadPointer(numChannels - 1, start);
+  for (int i = 0; i < numSamples; ++i) {
+    interleaved[(size_t)i] = Register(0.0f);
+    lanes[i * Register::size()] = inL[i];
+    lanes[i * Register::size() + 1] = inR[i];
+  }
+
+  // Band by band so each section's coefficients and state stay in registers
+  auto *x = interleaved.data();
+  for (int k = 0; k < cascadeLength; ++k) {
+    auto &sec = sections[(size_t)cascade[(size_t)k]];
+    Register b0 = sec.b0, b1 = sec.b1, b2 = sec.b2, a1 = sec.a1, a2 = sec.a2;
+    Register s1 = sec.s1, s2 = sec.s2;
 
-  if (numChannels > 1) {
-    auto *dataR = buffer.getWritePointer(1);
     for (int i = 0; i < numSamples; ++i) {
-      float s = dataR[i];
-      s = loCutFilterR.processSample(s);
-      s = bassFilterR.processSample(s);
-      s = midFilterR.processSample(s);
-      s = trebleFilterR.processSample(s);
-      s = airFilterR.processSample(s);
-      s = hiCutFilterR.processSample(s);
-      dataR[i] = s;
+      Register in = x[i];
+      Register out = b0 * in + s1;
+      s1 = b1 * in - a1 * out + s2;
+      s2 = b2 * in - a2 * out;
+      x[i] = out;
     }
+
+    sec.s1 = s1;
+    sec.s2 = s2;
+  }
+
+  for (int ch = 0; ch < numChannels; ++ch) {
+    auto *out = buffer.getWritePointer(ch, start);
+    for (int i = 0; i < numSamples; ++i)
+      out[i] = lanes[i * Register::size() + ch];
   }
 }
 
-void EQProcessor::updateParametersIfNeeded() {
+void EQProcessor::setSection(Band band, const Biquad &c, bool identity) {
+  auto &sec = sections[(size_t)band];
+
+  // Coming back into the cascade: start from rest, not stale state
+  if (sec.identity && !identity) {
+    sec.s1 = Register(0.0f);
+    sec.s2 = Register(0.0f);
+  }
+
+  sec.b0 = Register(c.b0);
+  sec.b1 = Register(c.b1);
+  sec.b2 = Register(c.b2);
+  sec.a1 = Register(c.a1);
+  sec.a2 = Register(c.a2);
+  sec.identity = identity;
+}
+
+void EQProcessor::compileCascade() {
+  cascadeLength = 0;
+  for (int b = 0; b < numBands; ++b)
+    if (!sections[(size_t)b].identity)
+      cascade[(size_t)cascadeLength++] = b;
+}
+
+//==============================================================================
+EQProcessor::Settings EQProcessor::getParameterSettings() const {
+  Settings s;
+  if (loCutParam == nullptr)
+    return s;
+
+  s.loCutHz = loCutParam->load();
+  s.bassDb = bassParam->load();
+  s.midFreqHz = midFreqParam->load();
+  s.midQ = midQParam->load();
+  s.midGainDb = midGainParam->load();
+  s.trebleDb = trebleParam->load();
+  s.airDb = airParam->load();
+  s.hiCutHz = hiCutParam->load();
+  return s;
+}
+
+void EQProcessor::setFixedSettings(const Settings &settings) {
+  fixedSettings = settings;
+  useFixedSettings = true;
+  smoothersInitialised = false;
+  updateTargets();
+}
+
+void EQProcessor::updateTargets() {
   if (sampleRate <= 0.0 || loCutParam == nullptr)
     return;
 
-  float loCut = loCutParam->load();
-  float bass = bassParam->load();
-  float midFreq = midFreqParam->load();
-  float midQ = midQParam->load();
-  float midGain = midGainParam->load();
-  float treble = trebleParam->load();
-  float air = airParam->load();
-  float hiCut = hiCutParam->load();
-
-  if (loCut != prevLoCut) {
-    auto c =
-        juce::dsp::IIR::Coefficients<float>::makeHighPass(sampleRate, loCut);
-    loCutFilterL.coefficients = c;
-    loCutFilterR.coefficients = c;
-    prevLoCut = loCut;
-  }
+  auto s = useFixedSettings ? fixedSettings : getParameterSettings();
 
-  if (bass != prevBass) {
-    auto c = juce::dsp::IIR::Coefficients<float>::makeLowShelf(
-        sampleRate, 100.0f, 0.707f, juce::Decibels::decibelsToGain(bass));
-    bassFilterL.coefficients = c;
-    bassFilterR.coefficients = c;
-    prevBass = bass;
-  }
+  // Keep every frequency safely below Nyquist
+  float maxHz = (float)(sampleRate * 0.49);
+  float loCut = juce::jmin(s.loCutHz, maxHz);
+  float midFreq = juce::jmin(s.midFreqHz, maxHz);
+  float hiCut = juce::jmin(s.hiCutHz, maxHz);
 
-  if (midFreq != prevMidFreq || midQ != prevMidQ || midGain != prevMidGain) {
-    auto c = juce::dsp::IIR::Coefficients<float>::makePeakFilter(
-        sampleRate, midFreq, midQ, juce::Decibels::decibelsToGain(midGain));
-    midFilterL.coefficients = c;
-    midFilterR.coefficients = c;
-    prevMidFreq = midFreq;
-    prevMidQ = midQ;
-    prevMidGain = midGain;
-  }
+  if (!smoothersInitialised) {
+    loCutHz.setCurrentAndTargetValue(loCut);
+    midFreqHz.setCurrentAndTargetValue(midFreq);
+    midQ.setCurrentAndTargetValue(s.midQ);
+    hiCutHz.setCurrentAndTargetValue(hiCut);
+    bassDb.setCurrentAndTargetValue(s.bassDb);
+    midGainDb.setCurrentAndTargetValue(s.midGainDb);
+    trebleDb.setCurrentAndTargetValue(s.trebleDb);
+    airDb.setCurrentAndTargetValue(s.airDb);
 
-  if (treble != prevTreble) {
-    auto c = juce::dsp::IIR::Coefficients<float>::makeHighShelf(
-        sampleRate, 3000.0f, 0.707f, juce::Decibels::decibelsToGain(treble));
-    trebleFilterL.coefficients = c;
-    trebleFilterR.coefficients = c;
-    prevTreble = treble;
+    for (int b = 0; b < numBands; ++b)
+      updateBand((Band)b);
+    compileCascade();
+    smoothersInitialised = true;
+    return;
   }
 
-  if (air != prevAir) {
-    auto c = juce::dsp::IIR::Coefficients<float>::makeHighShelf(
-        sampleRate, 10000.0f, 0.707f, juce::Decibels::decibelsToGain(air));
-    airFilterL.coefficients = c;
-    airFilterR.coefficients = c;
-    prevAir = air;
-  }
+  // No-ops unless the value actually moved
+  loCutHz.setTargetValue(loCut);
+  midFreqHz.setTargetValue(midFreq);
+  midQ.setTargetValue(s.midQ);
+  hiCutHz.setTargetValue(hiCut);
+  bassDb.setTargetValue(s.bassDb);
+  midGainDb.setTargetValue(s.midGainDb);
+  trebleDb.setTargetValue(s.trebleDb);
+  airDb.setTargetValue(s.airDb);
+}
+
+bool EQProcessor::isSmoothing() const {
+  return loCutHz.isSmoothing() || midFreqHz.isSmoothing() ||
+         midQ.isSmoothing() || hiCutHz.isSmoothing() || bassDb.isSmoothing() ||
+         midGainDb.isSmoothing() || trebleDb.isSmoothing() ||
+         airDb.isSmoothing();
+}
+
+void EQProcessor::advanceSmoothing(int numSamples) {
+  // Only the bands whose parameters are gliding get new coefficients
+  auto advance = [numSamples](auto &smoother) {
+    if (!smoother.isSmoothing())
+      return false;
+    smoother.skip(numSamples);
+    return true;
+  };
+
+  if (advance(loCutHz))
+    updateBand(Band::loCut);
+  if (advance(bassDb))
+    updateBand(Band::bass);
+
+  bool midMoved = advance(midFreqHz);
+  midMoved = advance(midQ) || midMoved;
+  midMoved = advance(midGainDb) || midMoved;
+  if (midMoved)
+    updateBand(Band::mid);
+
+  if (advance(trebleDb))
+    updateBand(Band::treble);
+  if (advance(airDb))
+    updateBand(Band::air);
+  if (advance(hiCutHz))
+    updateBand(Band::hiCut);
 
-  if (hiCut != prevHiCut) {
-    auto c =
-        juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, hiCut);
-    hiCutFilterL.coefficients = c;
-    hiCutFilterR.coefficients = c;
-    prevHiCut = hiCut;
+  compileCascade();
+}
+
+void EQProcessor::updateBand(Band band) {
+  switch (band) {
+  case Band::loCut:
+    setSection(band, makeHighPass(sampleRate, loCutHz.getCurrentValue()),
+               false);
+    break;
+  case Band::bass: {
+    float g = bassDb.getCurrentValue();
+    setSection(band, makeLowShelf(sampleRate, 100.0f, 0.707f, g),
+               std::abs(g) < flatGainDb);
+    break;
+  }
+  case Band::mid: {
+    float g = midGainDb.getCurrentValue();
+    setSection(band,
+               makePeak(sampleRate, midFreqHz.getCurrentValue(),
+                        midQ.getCurrentValue(), g),
+               std::abs(g) < flatGainDb);
+    break;
+  }
+  case Band::treble: {
+    float g = trebleDb.getCurrentValue();
+    setSection(band, makeHighShelf(sampleRate, 3000.0f, 0.707f, g),
+               std::abs(g) < flatGainDb);
+    break;
   }
+  case Band::air: {
+    float g = airDb.getCurrentValue();
+    setSection(band, makeHighShelf(sampleRate, 10000.0f, 0.707f, g),
+               std::abs(g) < flatGainDb);
+    break;
+  }
+  case Band::hiCut:
+    setSection(band, makeLowPass(sampleRate, hiCutHz.getCurrentValue()),
+               false);
+    break;
+  default:
+    break;
+  }
+}
+
+//==============================================================================
+// RBJ cookbook designs, matching juce::dsp::IIR::Coefficients but written
+// straight into a Biquad instead of a heap-allocated coefficients object.
+EQProcessor::Biquad EQProcessor::makeHighPass(double sampleRate, float freq) {
+  double n = std::tan(juce::MathConstants<double>::pi * freq / sampleRate);
+  double nSquared = n * n;
+  double invQ = juce::MathConstants<double>::sqrt2;
+  double c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+  Biquad c;
+  c.b0 = (float)c1;
+  c.b1 = (float)(c1 * -2.0);
+  c.b2 = (float)c1;
+  c.a1 = (float)(c1 * 2.0 * (nSquared - 1.0));
+  c.a2 = (float)(c1 * (1.0 - invQ * n + nSquared));
+  return c;
+}
+
+EQProcessor::Biquad EQProcessor::makeLowPass(double sampleRate, float freq) {
+  double n =
+      1.0 / std::tan(juce::MathConstants<double>::pi * freq / sampleRate);
+  double nSquared = n * n;
+  double invQ = juce::MathConstants<double>::sqrt2;
+  double c1 = 1.0 / (1.0 + invQ * n + nSquared);
+
+  Biquad c;
+  c.b0 = (float)c1;
+  c.b1 = (float)(c1 * 2.0);
+  c.b2 = (float)c1;
+  c.a1 = (float)(c1 * 2.0 * (1.0 - nSquared));
+  c.a2 = (float)(c1 * (1.0 - invQ * n + nSquared));
+  return c;
+}
+
+EQProcessor::Biquad EQProcessor::makeLowShelf(double sampleRate, float freq,
+                                              float q, float gainDb) {
+  double A = std::sqrt(juce::Decibels::decibelsToGain((double)gainDb));
+  double aminus1 = A - 1.0, aplus1 = A + 1.0;
+  double omega =
+      juce::MathConstants<double>::twoPi * juce::jmax(freq, 2.0f) / sampleRate;
+  double coso = std::cos(omega);
+  double beta = std::sin(omega) * std::sqrt(A) / q;
+  double aminus1TimesCoso = aminus1 * coso;
+
+  return normalise(A * (aplus1 - aminus1TimesCoso + beta),
+                   A * 2.0 * (aminus1 - aplus1 * coso),
+                   A * (aplus1 - aminus1TimesCoso - beta),
+                   aplus1 + aminus1TimesCoso + beta,
+                   -2.0 * (aminus1 + aplus1 * coso),
+                   aplus1 + aminus1TimesCoso - beta);
+}
+
+EQProcessor::Biquad EQProcessor::makeHighShelf(double sampleRate, float freq,
+                                               float q, float gainDb) {
+  double A = std::sqrt(juce::Decibels::decibelsToGain((double)gainDb));
+  double aminus1 = A - 1.0, aplus1 = A + 1.0;
+  double omega =
+      juce::MathConstants<double>::twoPi * juce::jmax(freq, 2.0f) / sampleRate;
+  double coso = std::cos(omega);
+  double beta = std::sin(omega) * std::sqrt(A) / q;
+  double aminus1TimesCoso = aminus1 * coso;
+
+  return normalise(A * (aplus1 + aminus1TimesCoso + beta),
+                   A * -2.0 * (aminus1 + aplus1 * coso),
+                   A * (aplus1 + aminus1TimesCoso - beta),
+                   aplus1 - aminus1TimesCoso + beta,
+                   2.0 * (aminus1 - aplus1 * coso),
+                   aplus1 - aminus1TimesCoso - beta);
+}
+
+EQProcessor::Biquad EQProcessor::makePeak(double sampleRate, float freq,
+                                          float q, float gainDb) {
+  double A = std::sqrt(juce::Decibels::decibelsToGain((double)gainDb));
+  double omega =
+      juce::MathConstants<double>::twoPi * juce::jmax(freq, 2.0f) / sampleRate;
+  double alpha = std::sin(omega) / (q * 2.0);
+  double c2 = -2.0 * std::cos(omega);
+  double alphaTimesA = alpha * A;
+  double alphaOverA = alpha / A;
+
+  return normalise(1.0 + alphaTimesA, c2, 1.0 - alphaTimesA, 1.0 + alphaOverA,
+                   c2, 1.0 - alphaOverA);
+}
+
+EQProcessor::Biquad EQProcessor::normalise(double b0, double b1, double b2,
+                                           double a0, double a1, double a2) {
+  double inv = 1.0 / a0;
+  Biquad c;
+  c.b0 = (float)(b0 * inv);
+  c.b1 = (float)(b1 * inv);
+  c.b2 = (float)(b2 * inv);
+  c.a1 = (float)(a1 * inv);
+  c.a2 = (float)(a2 * inv);
+  return c;
 }
@@ -2,6 +2,16 @@
 
 #include <JuceHeader.h>
 
+//==============================================================================
+// EQProcessor: the master six-band EQ, run as one compiled biquad cascade.
+// L and R share a SIMD register (one lane each) and every band is a
+// transposed direct form II section. Bands set flat are identity filters and
+// are left out of the cascade; it is recompiled only when a parameter moves.
+//
+// Parameter changes are smoothed and the coefficients recomputed in place
+// (RBJ cookbook, same formulas as juce::dsp::IIR::Coefficients) every
+// subBlockSize samples, so automation never allocates and never zips.
+//==============================================================================
 class EQProcessor {
 public:
   EQProcessor(juce::AudioProcessorValueTreeState &apvts);
@@ -11,17 +21,73 @@ public:
 
   void process(juce::AudioBuffer<float> &buffer);
 
+  // Snapshot of the eight EQ parameters
+  struct Settings {
+    float loCutHz = 80.0f, bassDb = 0.0f, midFreqHz = 1000.0f, midQ = 1.0f,
+          midGainDb = 0.0f, trebleDb = 0.0f, airDb = 0.0f, hiCutHz = 12000.0f;
+
+    bool operator==(const Settings &o) const {
+      return loCutHz == o.loCutHz && bassDb == o.bassDb &&
+             midFreqHz == o.midFreqHz && midQ == o.midQ &&
+             midGainDb == o.midGainDb && trebleDb == o.trebleDb &&
+             airDb == o.airDb && hiCutHz == o.hiCutHz;
+    }
+    bool operator!=(const Settings &o) const { return !(*this == o); }
+  };
+
+  // Reads the raw parameters; safe from any thread
+  Settings getParameterSettings() const;
+
+  // Offline rendering: ignore the parameters and use these from now on
+  void setFixedSettings(const Settings &settings);
+
+  // True while a parameter change is still gliding in
+  bool isSmoothing() const;
+
+  // Room left after a signal ends for the cascade to ring out, shared by
+  // the IR export, the tail report and the baked kernels
+  static constexpr double ringOutSeconds = 0.1;
+
+  // Normalised second-order section (a0 == 1)
+  struct Biquad {
+    float b0 = 1.0f, b1 = 0.0f, b2 = 0.0f, a1 = 0.0f, a2 = 0.0f;
+  };
+
+  // Allocation-free RBJ designs, also used by the per-slot tone bank
+  static Biquad makeHighPass(double sampleRate, float freq);
+  static Biquad makeLowPass(double sampleRate, float freq);
+  static Biquad makeLowShelf(double sampleRate, float freq, float q,
+                             float gainDb);
+  static Biquad makeHighShelf(double sampleRate, float freq, float q,
+                              float gainDb);
+  static Biquad makePeak(double sampleRate, float freq, float q, float gainDb);
+
 private:
+  using Register = juce::dsp::SIMDRegister<float>;
+
+  enum Band { loCut, bass, mid, treble, air, hiCut, numBands };
+
+  static Biquad normalise(double b0, double b1, double b2, double a0,
+                          double a1, double a2);
+
+  // One TDF-II section; coefficients are broadcast to every lane
+  struct Section {
+    Register b0, b1, b2, a1, a2;
+    Register s1, s2;
+    bool identity = false;
+  };
+
   juce::AudioProcessorValueTreeState &apvts;
   double sampleRate = 48000.0;
 
-  // Individual filters (not a chain, for clarity and control)
-  juce::dsp::IIR::Filter<float> loCutFilterL, loCutFilterR;
-  juce::dsp::IIR::Filter<float> bassFilterL, bassFilterR;
-  juce::dsp::IIR::Filter<float> midFilterL, midFilterR;
-  juce::dsp::IIR::Filter<float> trebleFilterL, trebleFilterR;
-  juce::dsp::IIR::Filter<float> airFilterL, airFilterR;
-  juce::dsp::IIR::Filter<float> hiCutFilterL, hiCutFilterR;
+  std::array<Section, numBands> sections;
+
+  // Compiled cascade: indices of the non-identity sections, in band order
+  std::array<int, numBands> cascade{};
+  int cascadeLength = 0;
+
+  // Interleaved working buffer: one register per sample, lane 0 = L, 1 = R
+  std::vector<Register> interleaved;
 
   // Cached raw parameter pointers (resolved once in prepare, never reallocated)
   std::atomic<float> *loCutParam = nullptr;
@@ -33,16 +99,29 @@ private:
   std::atomic<float> *airParam = nullptr;
   std::atomic<float> *hiCutParam = nullptr;
 
-  // Previous values for change detection (avoids coefficient recalc every block)
-  float prevLoCut = -1.0f;
-  float prevBass = -999.0f;
-  float prevMidFreq = -1.0f;
-  float prevMidQ = -1.0f;
-  float prevMidGain = -999.0f;
-  float prevTreble = -999.0f;
-  float prevAir = -999.0f;
-  float prevHiCut = -1.0f;
-
-  void updateParametersIfNeeded();
+  // Smoothed parameters: frequencies and Q glide multiplicatively, gains in dB
+  using FreqSmoother =
+      juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>;
+  FreqSmoother loCutHz, midFreqHz, midQ, hiCutHz;
+  juce::SmoothedValue<float> bassDb, midGainDb, trebleDb, airDb;
+  bool smoothersInitialised = false;
+
+  Settings fixedSettings;
+  bool useFixedSettings = false;
+
+  // Gains closer to 0 dB than this make a shelf or peak an identity filter
+  static constexpr float flatGainDb = 0.01f;
+
+  // Coefficients are refreshed this often while a parameter glides
+  static constexpr int subBlockSize = 32;
+  static constexpr double smoothingSeconds = 0.02;
+
+  void processChunk(juce::AudioBuffer<float> &buffer, int numChannels,
+                    int start, int numSamples);
+  void updateTargets();
+  void advanceSmoothing(int numSamples);
+  void updateBand(Band band);
   void cacheParameterPointers();
+  void setSection(Band band, const Biquad &c, bool identity);
+  void compileCascade();
 };
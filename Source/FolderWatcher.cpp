@@ -0,0 +1,263 @@
+#include "FolderWatcher.h"
+
+#if JUCE_LINUX
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+FolderWatcher::FolderWatcher() : juce::Thread("FreeIR Folder Watcher") {
+#if JUCE_LINUX
+  polling = !openNotify();
+#endif
+  startThread(juce::Thread::Priority::low);
+}
+
+FolderWatcher::~FolderWatcher() {
+  signalThreadShouldExit();
+  wake();
+  stopThread(4000);
+
+#if JUCE_LINUX
+  closeNotify();
+  for (auto &fd : wakePipe)
+    if (fd >= 0)
+      ::close(fd);
+#endif
+}
+
+bool FolderWatcher::watch(const juce::File &folder) {
+  {
+    const juce::ScopedLock sl(rootLock);
+    for (auto &root : roots)
+      if (folder == root || folder.isAChildOf(root))
+        return false;
+
+    roots.add(folder);
+    pendingRoots.add(folder);
+  }
+  wake();
+  return true;
+}
+
+void FolderWatcher::wake() {
+  notify();
+#if JUCE_LINUX
+  if (wakePipe[1] >= 0) {
+    char byte = 0;
+    [[maybe_unused]] auto written = ::write(wakePipe[1], &byte, 1);
+  }
+#endif
+}
+
+void FolderWatcher::addPendingRoots() {
+  juce::Array<juce::File> added;
+  {
+    const juce::ScopedLock sl(rootLock);
+    added.swapWith(pendingRoots);
+  }
+
+  for (auto &root : added) {
+#if JUCE_LINUX
+    if (!polling && addWatches(root))
+      continue;
+    if (!polling)
+      switchToPolling();
+#endif
+    recordDirectoryTimes(root);
+  }
+}
+
+//==============================================================================
+void FolderWatcher::run() {
+  std::set<juce::String> changed;
+
+  while (!threadShouldExit()) {
+    addPendingRoots();
+    bool quiet = true;
+
+#if JUCE_LINUX
+    if (!polling) {
+      pollfd fds[2] = {{notifyFd, POLLIN, 0}, {wakePipe[0], POLLIN, 0}};
+      int timeout = changed.empty() ? -1 : settleMs;
+      if (::poll(fds, 2, timeout) > 0) {
+        char drain[64];
+        if ((fds[1].revents & POLLIN) != 0)
+          while (::read(wakePipe[0], drain, sizeof(drain)) > 0) {
+          }
+        if ((fds[0].revents & POLLIN) != 0)
+          readEvents(changed);
+        quiet = false;
+      }
+    }
+#endif
+
+    if (polling) {
+      if (wait(changed.empty() ? pollIntervalMs : settleMs))
+        continue; // Woken for new roots or to exit
+      auto before = changed.size();
+      pollDirectories(changed);
+      quiet = changed.size() == before;
+    }
+
+    if (quiet && !changed.empty() && !threadShouldExit()) {
+      juce::Array<juce::File> paths;
+      for (auto &path : changed)
+        paths.add(juce::File(path));
+      changed.clear();
+
+      if (onChange)
+        onChange(paths);
+    }
+  }
+}
+
+//==============================================================================
+void FolderWatcher::recordDirectoryTimes(const juce::File &root) {
+  directoryTimes[root.getFullPathName()] =
+      root.getLastModificationTime().toMilliseconds();
+  for (const auto &item : juce::RangedDirectoryIterator(
+           root, true, "*", juce::File::findDirectories))
+    directoryTimes[item.getFile().getFullPathName()] =
+        item.getModificationTime().toMilliseconds();
+}
+
+void FolderWatcher::pollDirectories(std::set<juce::String> &changed) {
+  // A directory's modification time moves when entries are added, removed or
+  // renamed in it; files rewritten in place go unnoticed here
+  juce::Array<juce::File> currentRoots;
+  {
+    const juce::ScopedLock sl(rootLock);
+    currentRoots = roots;
+  }
+
+  std::map<juce::String, juce::int64> seen;
+  for (auto &root : currentRoots) {
+    if (root.isDirectory())
+      seen[root.getFullPathName()] =
+          root.getLastModificationTime().toMilliseconds();
+    for (const auto &item : juce::RangedDirectoryIterator(
+             root, true, "*", juce::File::findDirectories)) {
+      if (threadShouldExit())
+        return;
+      seen[item.getFile().getFullPathName()] =
+          item.getModificationTime().toMilliseconds();
+    }
+  }
+
+  for (auto &[path, time] : seen) {
+    auto known = directoryTimes.find(path);
+    if (known == directoryTimes.end() || known->second != time)
+      changed.insert(path);
+  }
+  for (auto &[path, time] : directoryTimes)
+    if (seen.count(path) == 0)
+      changed.insert(path);
+
+  directoryTimes = std::move(seen);
+}
+
+#if JUCE_LINUX
+//==============================================================================
+bool FolderWatcher::openNotify() {
+  notifyFd = ::inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (notifyFd < 0)
+    return false;
+
+  if (::pipe2(wakePipe, O_NONBLOCK | O_CLOEXEC) != 0) {
+    wakePipe[0] = wakePipe[1] = -1;
+    closeNotify();
+    return false;
+  }
+  return true;
+}
+
+void FolderWatcher::closeNotify() {
+  if (notifyFd >= 0)
+    ::close(notifyFd);
+  notifyFd = -1;
+  watchedDirs.clear();
+}
+
+void FolderWatcher::switchToPolling() {
+  // Out of inotify watches: fall back for every tree, not just this one
+  closeNotify();
+  polling = true;
+
+  juce::Array<juce::File> currentRoots;
+  {
+    const juce::ScopedLock sl(rootLock);
+    currentRoots = roots;
+  }
+  for (auto &root : currentRoots)
+    recordDirectoryTimes(root);
+}
+
+bool FolderWatcher::addWatches(const juce::File &dir) {
+  constexpr uint32_t mask = IN_CREATE | IN_DELETE | IN_MOVED_FROM |
+                            IN_MOVED_TO | IN_CLOSE_WRITE | IN_ONLYDIR;
+
+  // Adding an inode that is already watched returns the same descriptor,
+  // which re-points it at the directory's new path after a rename
+  auto add = [this](const juce::File &d) {
+    int wd = ::inotify_add_watch(notifyFd, d.getFullPathName().toRawUTF8(),
+                                 mask);
+    if (wd < 0)
+      return errno != ENOSPC && errno != ENOMEM; // Vanished dirs are fine
+    watchedDirs[wd] = d.getFullPathName();
+    return true;
+  };
+
+  if (!add(dir))
+    return false;
+  for (const auto &item : juce::RangedDirectoryIterator(
+           dir, true, "*", juce::File::findDirectories))
+    if (!add(item.getFile()))
+      return false;
+  return true;
+}
+
+void FolderWatcher::readEvents(std::set<juce::String> &changed) {
+  alignas(inotify_event) char buffer[16 * 1024];
+
+  for (;;) {
+    auto length = ::read(notifyFd, buffer, sizeof(buffer));
+    if (length <= 0)
+      return;
+
+    for (char *p = buffer; p < buffer + length;) {
+      const auto *event = reinterpret_cast<const inotify_event *>(p);
+      p += sizeof(inotify_event) + event->len;
+
+      if ((event->mask & IN_Q_OVERFLOW) != 0) {
+        // Events were lost; have every tree looked at again
+        const juce::ScopedLock sl(rootLock);
+        for (auto &root : roots)
+          changed.insert(root.getFullPathName());
+        continue;
+      }
+      if ((event->mask & IN_IGNORED) != 0) {
+        watchedDirs.erase(event->wd);
+        continue;
+      }
+
+      auto dir = watchedDirs.find(event->wd);
+      if (dir == watchedDirs.end() || event->len == 0)
+        continue;
+
+      juce::File path(dir->second + juce::File::getSeparatorString() +
+                      juce::String::fromUTF8(event->name));
+      changed.insert(path.getFullPathName());
+
+      if ((event->mask & IN_ISDIR) != 0 &&
+          (event->mask & (IN_CREATE | IN_MOVED_TO)) != 0 &&
+          !addWatches(path)) {
+        switchToPolling();
+        return;
+      }
+    }
+  }
+}
+#endif
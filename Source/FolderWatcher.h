@@ -0,0 +1,65 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <map>
+#include <set>
+#include <unordered_map>
+
+//==============================================================================
+// FolderWatcher: reports paths that were created, deleted, renamed or
+// rewritten anywhere below a set of watched folder trees.
+//
+// On Linux it subscribes to inotify, one watch per directory, and the thread
+// sleeps until the kernel reports something. Elsewhere, or when inotify is
+// unavailable or out of watches, it compares directory modification times
+// every pollIntervalMs instead. Events are held until the tree has been quiet
+// for settleMs, so a bulk copy arrives as one batch.
+// Polling sees entries appear, vanish and get renamed, but not files
+// rewritten in place.
+//==============================================================================
+class FolderWatcher : private juce::Thread {
+public:
+  FolderWatcher();
+  ~FolderWatcher() override;
+
+  // Called on the watcher thread with the changed paths: files or folders,
+  // which may no longer exist
+  std::function<void(const juce::Array<juce::File> &)> onChange;
+
+  // Any thread. False if the folder was already inside a watched tree.
+  bool watch(const juce::File &folder);
+
+private:
+  void run() override;
+  void wake();
+
+  // Picks up folders passed to watch() since the last call
+  void addPendingRoots();
+
+  // Polling fallback: reports directories whose modification time moved
+  void pollDirectories(std::set<juce::String> &changed);
+  void recordDirectoryTimes(const juce::File &root);
+
+#if JUCE_LINUX
+  bool openNotify();
+  void closeNotify();
+  void switchToPolling();
+  bool addWatches(const juce::File &dir);
+  void readEvents(std::set<juce::String> &changed);
+
+  int notifyFd = -1;
+  int wakePipe[2] = {-1, -1};
+  std::unordered_map<int, juce::String> watchedDirs; // Watch descriptor -> path
+#endif
+
+  juce::CriticalSection rootLock;
+  juce::Array<juce::File> roots, pendingRoots;
+
+  bool polling = true;
+  std::map<juce::String, juce::int64> directoryTimes;
+
+  static constexpr int settleMs = 300;
+  static constexpr int pollIntervalMs = 5000;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FolderWatcher)
+};
@@ -0,0 +1,173 @@
+#include "HostedPlugin.h"
+
+HostedPlugin::HostedPlugin() {
+  for (auto &hazard : inUse)
+    hazard.store(nullptr);
+  fade.setCurrentAndTargetValue(1.0f);
+}
+
+HostedPlugin::~HostedPlugin() {
+  stopTimer();
+  cancelPendingUpdate();
+  if (instance != nullptr)
+    instance->removeListener(this);
+  published = nullptr;
+  for (auto &hazard : inUse)
+    hazard = nullptr;
+
+  destroyRetired(true);
+  if (instance != nullptr)
+    instance->releaseResources();
+  instance.reset();
+}
+
+void HostedPlugin::setInstance(
+    std::unique_ptr<juce::AudioPluginInstance> newInstance) {
+  std::unique_ptr<juce::AudioPluginInstance> old(instance.release());
+  instance = std::move(newInstance);
+  published.store(instance.get());
+
+  if (old != nullptr) {
+    old->removeListener(this);
+    retired.push_back(std::move(old));
+    startTimerHz(20);
+  }
+
+  if (instance != nullptr)
+    instance->addListener(this);
+
+  refreshReportedValues();
+}
+
+void HostedPlugin::handleAsyncUpdate() { refreshReportedValues(); }
+
+void HostedPlugin::refreshReportedValues() {
+  int newLatency = 0;
+  double newTail = 0.0;
+  if (instance != nullptr) {
+    newLatency = instance->getLatencySamples();
+    newTail = instance->getTailLengthSeconds();
+  }
+
+  bool changed = newLatency != latencySamples.load() ||
+                 newTail != tailSeconds.load();
+  latencySamples = newLatency;
+  tailSeconds = newTail;
+
+  if (changed && onLatencyChanged)
+    onLatencyChanged();
+}
+
+void HostedPlugin::prepare(double sampleRate, int maxBlockSize) {
+  currentSampleRate = sampleRate;
+  fade.reset(sampleRate, fadeSeconds);
+  fade.setCurrentAndTargetValue(1.0f);
+  fadeBuffer.setSize(2, maxBlockSize);
+  fadeMidi.ensureSize(256);
+
+  if (instance != nullptr)
+    instance->prepareToPlay(sampleRate, maxBlockSize);
+}
+
+void HostedPlugin::releaseResources() {
+  // Audio is stopped, so no processing thread can be holding a hazard
+  for (auto &hazard : inUse)
+    hazard = nullptr;
+  current = nullptr;
+  previous = nullptr;
+
+  destroyRetired(true);
+  if (instance != nullptr)
+    instance->releaseResources();
+}
+
+juce::AudioPluginInstance *HostedPlugin::acquirePublished() {
+  auto *p = published.load();
+  for (;;) {
+    inUse[0].store(p);
+    auto *check = published.load();
+    if (check == p)
+      return p;
+    p = check;
+  }
+}
+
+void HostedPlugin::process(juce::AudioBuffer<float> &buffer,
+                           juce::MidiBuffer &midi,
+                           juce::AudioPlayHead *playHead) {
+  if (published.load() != current) {
+    // Keep the outgoing instance alive (and running) for the fade. It is
+    // still covered by inUse[0] until the new one is acquired below.
+    previous = current;
+    inUse[1].store(previous);
+    current = acquirePublished();
+
+    if (current == previous) {
+      previous = nullptr;
+      inUse[1].store(nullptr);
+    } else {
+      fade.setCurrentAndTargetValue(0.0f);
+      fade.setTargetValue(1.0f);
+    }
+  }
+
+  int numSamples = buffer.getNumSamples();
+  int numChannels = buffer.getNumChannels();
+  bool fading = fade.isSmoothing();
+
+  if (fading) {
+    fadeBuffer.setSize(numChannels, numSamples, false, false, true);
+    for (int ch = 0; ch < numChannels; ++ch)
+      fadeBuffer.copyFrom(ch, 0, buffer, ch, 0, numSamples);
+
+    // No outgoing instance means we are fading in from the dry signal
+    if (previous != nullptr) {
+      fadeMidi.clear();
+      previous->setPlayHead(playHead);
+      previous->processBlock(fadeBuffer, fadeMidi);
+    }
+  }
+
+  if (current != nullptr) {
+    current->setPlayHead(playHead);
+    current->processBlock(buffer, midi);
+  }
+
+  if (fading) {
+    for (int i = 0; i < numSamples; ++i) {
+      float g = fade.getNextValue();
+      for (int ch = 0; ch < numChannels; ++ch) {
+        auto *out = buffer.getWritePointer(ch);
+        out[i] = out[i] * g + fadeBuffer.getSample(ch, i) * (1.0f - g);
+      }
+    }
+
+    if (!fade.isSmoothing()) {
+      previous = nullptr;
+      inUse[1].store(nullptr);
+    }
+  }
+}
+
+void HostedPlugin::timerCallback() {
+  destroyRetired(false);
+  if (retired.empty())
+    stopTimer();
+}
+
+void HostedPlugin::destroyRetired(bool force) {
+  // Read [0] before [1]: the processing thread fills [1] before it moves
+  // [0] on, so this order can never miss an instance that is mid-handover
+  auto *hazard0 = inUse[0].load();
+  auto *hazard1 = inUse[1].load();
+
+  for (auto it = retired.begin(); it != retired.end();) {
+    auto *p = it->get();
+    if (force || (p != hazard0 && p != hazard1)) {
+      (*it)->releaseResources();
+      it = retired.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
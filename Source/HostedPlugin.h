@@ -0,0 +1,81 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// HostedPlugin: owns one hosted plugin instance (amp sim, pedal...) and lets
+// the audio thread use it without ever taking a lock.
+//
+// The message thread publishes a prepared instance through an atomic pointer.
+// The processing thread marks the instance it is using in a hazard pointer,
+// and replaced instances are only torn down -- on the message thread, as
+// plugin formats require -- once no hazard points at them. A short crossfade
+// covers every swap, including load and unload.
+//==============================================================================
+class HostedPlugin : private juce::Timer,
+                     private juce::AsyncUpdater,
+                     private juce::AudioProcessorListener {
+public:
+  HostedPlugin();
+  ~HostedPlugin() override;
+
+  // Message thread. Publishes an already prepared instance (or nullptr to
+  // unload); the previous one is retired and destroyed later.
+  void setInstance(std::unique_ptr<juce::AudioPluginInstance> newInstance);
+  juce::AudioPluginInstance *getInstance() const { return instance.get(); }
+
+  // Cached from the current instance; safe to read from any thread
+  int getLatencySamples() const { return latencySamples; }
+  double getTailLengthSeconds() const { return tailSeconds; }
+
+  // Message thread: the instance's latency or tail changed (or it swapped)
+  std::function<void()> onLatencyChanged;
+
+  // Message thread, audio stopped
+  void prepare(double sampleRate, int maxBlockSize);
+  void releaseResources();
+
+  // Processing thread (one at a time): runs the published instance in place
+  void process(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midi,
+               juce::AudioPlayHead *playHead);
+
+private:
+  void timerCallback() override;
+  void destroyRetired(bool force);
+
+  // Plugins report latency changes from any thread; refresh on the
+  // message thread
+  void handleAsyncUpdate() override;
+  void audioProcessorParameterChanged(juce::AudioProcessor *, int,
+                                      float) override {}
+  void audioProcessorChanged(juce::AudioProcessor *,
+                             const ChangeDetails &) override {
+    triggerAsyncUpdate();
+  }
+  void refreshReportedValues();
+
+  // Re-reads the published pointer until the hazard provably covers it
+  juce::AudioPluginInstance *acquirePublished();
+
+  std::unique_ptr<juce::AudioPluginInstance> instance; // message thread
+  std::vector<std::unique_ptr<juce::AudioPluginInstance>> retired;
+
+  std::atomic<juce::AudioPluginInstance *> published{nullptr};
+  std::atomic<int> latencySamples{0};
+  std::atomic<double> tailSeconds{0.0};
+
+  // Hazard pointers: [0] = current instance, [1] = instance fading out
+  std::array<std::atomic<juce::AudioPluginInstance *>, 2> inUse{};
+
+  // Processing thread state
+  juce::AudioPluginInstance *current = nullptr;
+  juce::AudioPluginInstance *previous = nullptr;
+  juce::SmoothedValue<float> fade;
+  juce::AudioBuffer<float> fadeBuffer;
+  juce::MidiBuffer fadeMidi;
+
+  double currentSampleRate = 48000.0;
+  static constexpr double fadeSeconds = 0.01;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HostedPlugin)
+};
@@ -0,0 +1,367 @@
+#include "HostedPluginGraph.h"
+
+HostedPluginGraph::HostedPluginGraph() {
+  for (auto &hazard : inUse)
+    hazard.store(nullptr);
+  slotRouting.fill(mainInput);
+  rebuild();
+}
+
+HostedPluginGraph::~HostedPluginGraph() {
+  stopTimer();
+  for (auto &hazard : inUse)
+    hazard = nullptr;
+  destroyRetired(true);
+  delete published.exchange(nullptr);
+}
+
+//==============================================================================
+int HostedPluginGraph::addNode(Stage stage, int branch) {
+  auto node = std::make_unique<Node>();
+  node->id = nextNodeId++;
+  node->stage = stage;
+  node->branch = juce::jlimit(0, maxBranches - 1, branch);
+  node->plugin.onLatencyChanged = [this] { rebuild(); };
+  if (preparedSampleRate > 0.0)
+    node->plugin.prepare(preparedSampleRate, preparedBlockSize);
+
+  int id = node->id;
+  nodes.push_back(std::move(node));
+  rebuild();
+  return id;
+}
+
+int HostedPluginGraph::getOrCreatePrimaryNode() {
+  if (primaryNodeId >= 0)
+    return primaryNodeId;
+
+  primaryNodeId = addNode(Stage::pre);
+
+  // The primary node always leads the pre chain
+  auto it = std::find_if(nodes.begin(), nodes.end(),
+                         [this](auto &n) { return n->id == primaryNodeId; });
+  std::rotate(nodes.begin(), it, it + 1);
+  rebuild();
+  return primaryNodeId;
+}
+
+void HostedPluginGraph::removeNode(int nodeId) {
+  auto it = std::find_if(nodes.begin(), nodes.end(),
+                         [nodeId](auto &n) { return n->id == nodeId; });
+  if (it == nodes.end())
+    return;
+
+  // The published schedule may still point at it; it is destroyed together
+  // with that schedule once neither processing thread can see it
+  removedNodes.push_back(std::move(*it));
+  nodes.erase(it);
+  if (nodeId == primaryNodeId)
+    primaryNodeId = -1;
+  rebuild();
+}
+
+void HostedPluginGraph::setNodeBypassed(int nodeId, bool shouldBeBypassed) {
+  if (auto *node = findNode(nodeId); node != nullptr) {
+    if (node->bypassed != shouldBeBypassed) {
+      node->bypassed = shouldBeBypassed;
+      rebuild();
+    }
+  }
+}
+
+void HostedPluginGraph::setNodeInstance(
+    int nodeId, std::unique_ptr<juce::AudioPluginInstance> instance) {
+  // Latency changes come back through the node's onLatencyChanged
+  if (auto *node = findNode(nodeId); node != nullptr)
+    node->plugin.setInstance(std::move(instance));
+}
+
+juce::AudioPluginInstance *
+HostedPluginGraph::getNodeInstance(int nodeId) const {
+  auto *node = findNode(nodeId);
+  return node != nullptr ? node->plugin.getInstance() : nullptr;
+}
+
+std::vector<HostedPluginGraph::NodeInfo> HostedPluginGraph::getNodes() const {
+  std::vector<NodeInfo> result;
+  for (auto &node : nodes) {
+    NodeInfo info;
+    info.id = node->id;
+    info.stage = node->stage;
+    info.branch = node->branch;
+    info.bypassed = node->bypassed;
+    if (auto *instance = node->plugin.getInstance())
+      info.name = instance->getName();
+    result.push_back(info);
+  }
+  return result;
+}
+
+void HostedPluginGraph::setSlotInput(int slotIndex, int branch) {
+  if (slotIndex < 0 || slotIndex >= numSlots)
+    return;
+
+  slotRouting[(size_t)slotIndex] =
+      branch < 0 ? mainInput : juce::jmin(branch, maxBranches - 1);
+  rebuild();
+}
+
+int HostedPluginGraph::getSlotInput(int slotIndex) const {
+  if (slotIndex < 0 || slotIndex >= numSlots)
+    return mainInput;
+  return slotRouting[(size_t)slotIndex];
+}
+
+HostedPluginGraph::Node *HostedPluginGraph::findNode(int nodeId) const {
+  for (auto &node : nodes)
+    if (node->id == nodeId)
+      return node.get();
+  return nullptr;
+}
+
+//==============================================================================
+void HostedPluginGraph::rebuild() {
+  auto schedule = std::make_unique<Schedule>();
+
+  int preLatency = 0, postLatency = 0;
+  double preTail = 0.0, postTail = 0.0;
+  std::array<int, maxBranches> branchLatency{};
+  std::array<double, maxBranches> branchTail{};
+
+  for (auto &node : nodes) {
+    if (node->bypassed)
+      continue;
+
+    auto *plugin = &node->plugin;
+    int latency = plugin->getLatencySamples();
+    double tail = plugin->getTailLengthSeconds();
+
+    switch (node->stage) {
+    case Stage::pre:
+      schedule->pre.push_back(plugin);
+      preLatency += latency;
+      preTail += tail;
+      break;
+    case Stage::branch:
+      schedule->branches[(size_t)node->branch].push_back(plugin);
+      branchLatency[(size_t)node->branch] += latency;
+      branchTail[(size_t)node->branch] += tail;
+      break;
+    case Stage::post:
+      schedule->post.push_back(plugin);
+      postLatency += latency;
+      postTail += tail;
+      break;
+    }
+  }
+
+  // A branch only runs if it has plugins and at least one slot listens to it
+  std::array<bool, maxBranches> active{};
+  for (int route : slotRouting)
+    if (route >= 0 && !schedule->branches[(size_t)route].empty())
+      active[(size_t)route] = true;
+
+  int maxBranchLatency = 0;
+  double maxBranchTail = 0.0;
+  for (int b = 0; b < maxBranches; ++b) {
+    if (!active[(size_t)b])
+      continue;
+    schedule->activeBranches[(size_t)schedule->numActiveBranches++] = b;
+    maxBranchLatency = juce::jmax(maxBranchLatency, branchLatency[(size_t)b]);
+    maxBranchTail = juce::jmax(maxBranchTail, branchTail[(size_t)b]);
+  }
+
+  bool anySlotOnMain = false;
+  for (int s = 0; s < numSlots; ++s) {
+    int route = slotRouting[(size_t)s];
+    bool onBranch = route >= 0 && active[(size_t)route];
+    schedule->slotInput[(size_t)s] = onBranch ? route : mainInput;
+    anySlotOnMain = anySlotOnMain || !onBranch;
+  }
+
+  for (int b = 0; b < maxBranches; ++b)
+    if (active[(size_t)b])
+      schedule->branchDelay[(size_t)b] =
+          maxBranchLatency - branchLatency[(size_t)b];
+  schedule->mainDelay = anySlotOnMain ? maxBranchLatency : 0;
+
+  // Publish, and retire the old schedule along with any nodes it still uses
+  auto *old = published.exchange(schedule.release());
+  if (old != nullptr) {
+    retired.push_back({std::unique_ptr<Schedule>(old), {}});
+    for (auto &node : removedNodes)
+      retired.back().nodes.push_back(std::move(node));
+    startTimerHz(20);
+  }
+  removedNodes.clear();
+
+  int newLatency = preLatency + maxBranchLatency + postLatency;
+  double newTail = preTail + maxBranchTail + postTail;
+  bool changed =
+      newLatency != totalLatency.load() || newTail != totalTailSeconds.load();
+  totalLatency = newLatency;
+  totalTailSeconds = newTail;
+
+  if (changed && onLatencyChanged)
+    onLatencyChanged();
+}
+
+void HostedPluginGraph::timerCallback() {
+  destroyRetired(false);
+  if (retired.empty())
+    stopTimer();
+}
+
+void HostedPluginGraph::destroyRetired(bool force) {
+  // Strictly oldest first: a node removed in one edit may also be referenced
+  // by earlier schedules, so a bundle can only go once everything before it
+  // has gone. Read [0] before [1] as in HostedPlugin.
+  auto *hazard0 = inUse[0].load();
+  auto *hazard1 = inUse[1].load();
+
+  while (!retired.empty()) {
+    auto *s = retired.front().schedule.get();
+    if (!force && (s == hazard0 || s == hazard1))
+      break;
+    retired.pop_front();
+  }
+}
+
+//==============================================================================
+void HostedPluginGraph::prepare(double sampleRate, int maxBlockSize) {
+  preparedSampleRate = sampleRate;
+  preparedBlockSize = maxBlockSize;
+
+  for (auto &node : nodes)
+    node->plugin.prepare(sampleRate, maxBlockSize);
+
+  // Compensation never needs more than a second
+  juce::dsp::ProcessSpec spec{sampleRate, (juce::uint32)maxBlockSize, 2};
+  int maxDelay = (int)sampleRate + maxBlockSize;
+
+  for (int b = 0; b < maxBranches; ++b) {
+    branchBuffers[(size_t)b].setSize(2, maxBlockSize);
+    branchMidi[(size_t)b].ensureSize(256);
+    branchDelays[(size_t)b].setMaximumDelayInSamples(maxDelay);
+    branchDelays[(size_t)b].prepare(spec);
+    lastBranchDelay[(size_t)b] = 0;
+  }
+
+  mainBuffer.setSize(2, maxBlockSize);
+  mainDelayLine.setMaximumDelayInSamples(maxDelay);
+  mainDelayLine.prepare(spec);
+  lastMainDelay = 0;
+}
+
+void HostedPluginGraph::releaseResources() {
+  for (auto &node : nodes)
+    node->plugin.releaseResources();
+
+  for (auto &hazard : inUse)
+    hazard = nullptr;
+  destroyRetired(true);
+}
+
+//==============================================================================
+const HostedPluginGraph::Schedule *
+HostedPluginGraph::acquire(ProcessingThread thread) {
+  auto &hazard = inUse[(size_t)thread];
+  auto *s = published.load();
+  for (;;) {
+    hazard.store(s);
+    auto *check = published.load();
+    if (check == s)
+      return s;
+    s = check;
+  }
+}
+
+void HostedPluginGraph::delayBuffer(CompensationDelay &delay,
+                                    juce::AudioBuffer<float> &b,
+                                    int delaySamples) {
+  delay.setDelay((float)delaySamples);
+  for (int ch = 0; ch < b.getNumChannels(); ++ch) {
+    auto *data = b.getWritePointer(ch);
+    for (int i = 0; i < b.getNumSamples(); ++i) {
+      delay.pushSample(ch, data[i]);
+      data[i] = delay.popSample(ch);
+    }
+  }
+}
+
+void HostedPluginGraph::processPre(juce::AudioBuffer<float> &buffer,
+                                   juce::MidiBuffer &midi,
+                                   juce::AudioPlayHead *playHead,
+                                   ProcessingThread thread) {
+  auto *schedule = acquire(thread);
+  for (auto *plugin : schedule->pre)
+    plugin->process(buffer, midi, playHead);
+  release(thread);
+}
+
+void HostedPluginGraph::processBranches(
+    const juce::AudioBuffer<float> &input, juce::AudioPlayHead *playHead,
+    RealtimeWorkerPool &workers,
+    std::array<const juce::AudioBuffer<float> *, numSlots> &slotInputs) {
+  auto *schedule = acquire(audioThread);
+  int numSamples = input.getNumSamples();
+  int numInputChannels = input.getNumChannels();
+
+  auto copyInput = [&](juce::AudioBuffer<float> &dest) {
+    dest.setSize(2, numSamples, false, false, true);
+    for (int ch = 0; ch < 2; ++ch)
+      dest.copyFrom(ch, 0, input, juce::jmin(ch, numInputChannels - 1), 0,
+                    numSamples);
+  };
+
+  // Slots fed straight from the pre chain still have to line up with the
+  // slowest branch
+  const juce::AudioBuffer<float> *mainOutput = &input;
+  if (schedule->mainDelay != lastMainDelay) {
+    mainDelayLine.reset();
+    lastMainDelay = schedule->mainDelay;
+  }
+  if (schedule->mainDelay > 0 && numInputChannels > 0) {
+    copyInput(mainBuffer);
+    delayBuffer(mainDelayLine, mainBuffer, schedule->mainDelay);
+    mainOutput = &mainBuffer;
+  }
+
+  auto runBranch = [&](int task) {
+    auto b = (size_t)schedule->activeBranches[(size_t)task];
+    auto &branchBuffer = branchBuffers[b];
+    copyInput(branchBuffer);
+    branchMidi[b].clear();
+
+    for (auto *plugin : schedule->branches[b])
+      plugin->process(branchBuffer, branchMidi[b], playHead);
+
+    if (schedule->branchDelay[b] != lastBranchDelay[b]) {
+      branchDelays[b].reset();
+      lastBranchDelay[b] = schedule->branchDelay[b];
+    }
+    if (schedule->branchDelay[b] > 0)
+      delayBuffer(branchDelays[b], branchBuffer, schedule->branchDelay[b]);
+  };
+
+  if (numInputChannels > 0)
+    workers.run(schedule->numActiveBranches, runBranch);
+
+  for (int s = 0; s < numSlots; ++s) {
+    int route = schedule->slotInput[(size_t)s];
+    slotInputs[(size_t)s] = (route >= 0 && numInputChannels > 0)
+                                ? &branchBuffers[(size_t)route]
+                                : mainOutput;
+  }
+
+  release(audioThread);
+}
+
+void HostedPluginGraph::processPost(juce::AudioBuffer<float> &buffer,
+                                    juce::MidiBuffer &midi,
+                                    juce::AudioPlayHead *playHead) {
+  auto *schedule = acquire(audioThread);
+  for (auto *plugin : schedule->post)
+    plugin->process(buffer, midi, playHead);
+  release(audioThread);
+}
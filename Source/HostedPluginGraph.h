@@ -0,0 +1,148 @@
+#pragma once
+
+#include "HostedPlugin.h"
+#include "RealtimeWorkerPool.h"
+#include <JuceHeader.h>
+
+//==============================================================================
+// HostedPluginGraph: a small series-parallel graph of hosted plugins.
+//
+//   input -> [pre chain] -+-> [branch 1] -> slots routed to branch 1
+//                         +-> [branch 2] -> slots routed to branch 2
+//                         +-> (direct)   -> slots on the main input
+//   IR mix -> EQ -> [post chain] -> output
+//
+// Edits happen on the message thread and are compiled into an immutable
+// schedule that is published atomically, the same way HostedPlugin publishes
+// instances. Bypassed nodes and branches no slot listens to are left out of
+// the schedule entirely. Active branches run in parallel on the worker pool
+// and are delay-compensated against the slowest one so slots stay aligned.
+//==============================================================================
+class HostedPluginGraph : private juce::Timer {
+public:
+  enum class Stage { pre, branch, post };
+  enum ProcessingThread { audioThread = 0, pipelineThread = 1 };
+
+  static constexpr int maxBranches = 4;
+  static constexpr int numSlots = 4;
+  static constexpr int mainInput = -1;
+
+  struct NodeInfo {
+    int id = -1;
+    Stage stage = Stage::pre;
+    int branch = 0;
+    bool bypassed = false;
+    juce::String name;
+  };
+
+  HostedPluginGraph();
+  ~HostedPluginGraph() override;
+
+  // --- Editing (message thread); every edit republishes the schedule ---
+  int addNode(Stage stage, int branch = 0);
+  void removeNode(int nodeId);
+  void setNodeBypassed(int nodeId, bool shouldBeBypassed);
+  void setNodeInstance(int nodeId,
+                       std::unique_ptr<juce::AudioPluginInstance> instance);
+  juce::AudioPluginInstance *getNodeInstance(int nodeId) const;
+  std::vector<NodeInfo> getNodes() const;
+
+  // The node behind the header "Load Plugin" button: first in the pre chain
+  int getOrCreatePrimaryNode();
+  int getPrimaryNode() const { return primaryNodeId; }
+
+  // Which branch feeds an IR slot (mainInput = straight from the pre chain)
+  void setSlotInput(int slotIndex, int branch);
+  int getSlotInput(int slotIndex) const;
+
+  // Total along the slowest path; safe to read from any thread
+  int getLatencySamples() const { return totalLatency; }
+  double getTailLengthSeconds() const { return totalTailSeconds; }
+
+  // Message thread: latency or tail of the compiled graph changed
+  std::function<void()> onLatencyChanged;
+
+  // Message thread, audio stopped
+  void prepare(double sampleRate, int maxBlockSize);
+  void releaseResources();
+
+  // --- Processing ---
+  void processPre(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midi,
+                  juce::AudioPlayHead *playHead, ProcessingThread thread);
+
+  // Runs the active branches (in parallel on `workers`) and points each
+  // slot at the buffer it should convolve
+  void processBranches(
+      const juce::AudioBuffer<float> &input, juce::AudioPlayHead *playHead,
+      RealtimeWorkerPool &workers,
+      std::array<const juce::AudioBuffer<float> *, numSlots> &slotInputs);
+
+  void processPost(juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midi,
+                   juce::AudioPlayHead *playHead);
+
+private:
+  using CompensationDelay = juce::dsp::DelayLine<
+      float, juce::dsp::DelayLineInterpolationTypes::None>;
+
+  struct Node {
+    int id = -1;
+    Stage stage = Stage::pre;
+    int branch = 0;
+    bool bypassed = false;
+    HostedPlugin plugin;
+  };
+
+  // Immutable once published
+  struct Schedule {
+    std::vector<HostedPlugin *> pre, post;
+    std::array<std::vector<HostedPlugin *>, maxBranches> branches;
+    std::array<int, maxBranches> branchDelay{};
+    std::array<int, maxBranches> activeBranches{};
+    int numActiveBranches = 0;
+    std::array<int, numSlots> slotInput{};
+    int mainDelay = 0;
+  };
+
+  // An old schedule plus the nodes only it still refers to
+  struct Retired {
+    std::unique_ptr<Schedule> schedule;
+    std::vector<std::unique_ptr<Node>> nodes;
+  };
+
+  void rebuild();
+  void timerCallback() override;
+  void destroyRetired(bool force);
+  Node *findNode(int nodeId) const;
+
+  const Schedule *acquire(ProcessingThread thread);
+  void release(ProcessingThread thread) { inUse[(size_t)thread] = nullptr; }
+
+  static void delayBuffer(CompensationDelay &delay, juce::AudioBuffer<float> &b,
+                          int delaySamples);
+
+  // Message thread
+  std::vector<std::unique_ptr<Node>> nodes;
+  std::vector<std::unique_ptr<Node>> removedNodes;
+  std::deque<Retired> retired;
+  std::array<int, numSlots> slotRouting{};
+  int primaryNodeId = -1;
+  int nextNodeId = 1;
+  double preparedSampleRate = 0.0;
+  int preparedBlockSize = 0;
+
+  std::atomic<Schedule *> published{nullptr};
+  std::array<std::atomic<const Schedule *>, 2> inUse{};
+  std::atomic<int> totalLatency{0};
+  std::atomic<double> totalTailSeconds{0.0};
+
+  // Audio thread
+  std::array<juce::AudioBuffer<float>, maxBranches> branchBuffers;
+  std::array<juce::MidiBuffer, maxBranches> branchMidi;
+  std::array<CompensationDelay, maxBranches> branchDelays;
+  std::array<int, maxBranches> lastBranchDelay{};
+  juce::AudioBuffer<float> mainBuffer;
+  CompensationDelay mainDelayLine;
+  int lastMainDelay = 0;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(HostedPluginGraph)
+};
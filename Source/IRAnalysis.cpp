@@ -0,0 +1,177 @@
+#include "IRAnalysis.h"
+
+#include <numeric>
+
+namespace {
+// TDF-II biquad in double precision; a0 is 1
+struct KStage {
+  double b0, b1, b2, a1, a2;
+  double s1 = 0.0, s2 = 0.0;
+
+  double process(double x) {
+    double y = b0 * x + s1;
+    s1 = b1 * x - a1 * y + s2;
+    s2 = b2 * x - a2 * y;
+    return y;
+  }
+};
+
+// BS.1770 pre-filter (head shelf) and RLB high-pass, designed for any rate
+// from the analogue prototypes rather than the tabulated 48 kHz values
+std::array<KStage, 2> makeKWeighting(double sampleRate) {
+  double k = std::tan(juce::MathConstants<double>::pi * 1681.974450955533 /
+                      sampleRate);
+  double q = 0.7071752369554196;
+  double vh = std::pow(10.0, 3.999843853973347 / 20.0);
+  double vb = std::pow(vh, 0.4996667741545416);
+  double a0 = 1.0 + k / q + k * k;
+  KStage shelf{(vh + vb * k / q + k * k) / a0, 2.0 * (k * k - vh) / a0,
+               (vh - vb * k / q + k * k) / a0, 2.0 * (k * k - 1.0) / a0,
+               (1.0 - k / q + k * k) / a0};
+
+  k = std::tan(juce::MathConstants<double>::pi * 38.13547087602444 /
+               sampleRate);
+  q = 0.5003270373238773;
+  a0 = 1.0 + k / q + k * k;
+  KStage highPass{1.0, -2.0, 1.0, 2.0 * (k * k - 1.0) / a0,
+                  (1.0 - k / q + k * k) / a0};
+
+  return {shelf, highPass};
+}
+
+float toDb(double power) {
+  return power > 0.0 ? (float)juce::jmax(-100.0, 10.0 * std::log10(power))
+                     : -100.0f;
+}
+
+// Spectra cover at most 2^15 samples, zero-padded to at least 2^12 so the
+// lowest fingerprint bands still see a few bins
+constexpr int minSpectrumOrder = 12;
+constexpr int maxSpectrumOrder = 15;
+
+// The filters ring on past the IR; this much silence lets them settle
+constexpr double kWeightingTailSeconds = 0.1;
+} // namespace
+
+IRAnalysis IRAnalysis::measure(const juce::AudioBuffer<float> &ir,
+                               double sampleRate) {
+  IRAnalysis result;
+  int numChannels = ir.getNumChannels();
+  int numSamples = ir.getNumSamples();
+  if (numChannels == 0 || numSamples == 0 || sampleRate <= 0.0)
+    return result;
+
+  // 1. Peak, energy, K-weighted energy and the energy envelope
+  std::vector<float> envelope((size_t)numSamples, 0.0f);
+  std::vector<float> squared((size_t)numSamples);
+  double maxEnergy = 0.0, weightedEnergy = 0.0;
+  int tail = (int)(kWeightingTailSeconds * sampleRate);
+
+  for (int ch = 0; ch < numChannels; ++ch) {
+    auto *x = ir.getReadPointer(ch);
+    auto range = juce::FloatVectorOperations::findMinAndMax(x, numSamples);
+    result.peak =
+        juce::jmax(result.peak, -range.getStart(), range.getEnd());
+
+    juce::FloatVectorOperations::multiply(squared.data(), x, x, numSamples);
+    juce::FloatVectorOperations::add(envelope.data(), squared.data(),
+                                     numSamples);
+    maxEnergy = juce::jmax(
+        maxEnergy, std::accumulate(squared.begin(), squared.end(), 0.0));
+
+    // Recursive, so sample by sample
+    auto stages = makeKWeighting(sampleRate);
+    for (int i = 0; i < numSamples + tail; ++i) {
+      double y = i < numSamples ? (double)x[i] : 0.0;
+      for (auto &stage : stages)
+        y = stage.process(y);
+      weightedEnergy += y * y;
+    }
+  }
+
+  result.energyDb = toDb(maxEnergy);
+  result.loudnessDb = -0.691f + toDb(weightedEnergy / numChannels);
+  if (result.peak <= 0.0f)
+    return result;
+
+  // 2. Onset: the first sample within 20 dB of the peak on any channel
+  float onsetLevel = result.peak * 0.1f;
+  int onset = numSamples - 1;
+  for (int ch = 0; ch < numChannels; ++ch) {
+    auto *x = ir.getReadPointer(ch);
+    for (int i = 0; i < onset; ++i) {
+      if (std::abs(x[i]) >= onsetLevel) {
+        onset = i;
+        break;
+      }
+    }
+  }
+  result.onsetMs = (float)(1000.0 * onset / sampleRate);
+
+  // 3. Effective length: backwards until the remaining energy is -60 dB
+  double total = std::accumulate(envelope.begin(), envelope.end(), 0.0);
+  double remaining = 0.0;
+  int end = numSamples;
+  while (end > 0 && remaining + envelope[(size_t)end - 1] <= total * 1.0e-6)
+    remaining += envelope[(size_t)--end];
+  result.effectiveLengthMs = (float)(1000.0 * end / sampleRate);
+
+  // 4. Spectrum of the channel sum: centroid and fingerprint
+  int order = juce::jlimit(minSpectrumOrder, maxSpectrumOrder,
+                           juce::roundToInt(std::ceil(std::log2(numSamples))));
+  int fftSize = 1 << order;
+  int used = juce::jmin(numSamples, fftSize);
+  std::vector<float> spectrum((size_t)fftSize * 2, 0.0f);
+  for (int ch = 0; ch < numChannels; ++ch)
+    juce::FloatVectorOperations::add(spectrum.data(), ir.getReadPointer(ch),
+                                     used);
+
+  juce::dsp::FFT fft(order);
+  fft.performFrequencyOnlyForwardTransform(spectrum.data(), true);
+
+  int numBins = fftSize / 2;
+  double weighted = 0.0, sum = 0.0;
+  for (int bin = 1; bin <= numBins; ++bin) {
+    weighted += (double)bin * spectrum[(size_t)bin];
+    sum += spectrum[(size_t)bin];
+  }
+  if (sum > 0.0)
+    result.spectralCentroidHz = (float)(weighted / sum * sampleRate / fftSize);
+
+  // Bands past Nyquist repeat the last one that fits
+  double binHz = sampleRate / fftSize;
+  double ratio = std::pow(fingerprintHiHz / fingerprintLoHz,
+                          1.0 / numFingerprintBands);
+  double bandMean = 0.0;
+  for (int band = 0; band < numFingerprintBands; ++band) {
+    double lo = fingerprintLoHz * std::pow(ratio, band);
+    int first = juce::jlimit(1, numBins, (int)std::ceil(lo / binHz));
+    int last = juce::jlimit(first, numBins, (int)(lo * ratio / binHz));
+
+    double power = 0.0;
+    for (int bin = first; bin <= last; ++bin)
+      power += (double)spectrum[(size_t)bin] * spectrum[(size_t)bin];
+    float level = toDb(power / (last - first + 1));
+    if (lo >= sampleRate * 0.5 && band > 0)
+      level = result.fingerprint[(size_t)band - 1];
+
+    result.fingerprint[(size_t)band] = level;
+    bandMean += level;
+  }
+  bandMean /= numFingerprintBands;
+  for (auto &level : result.fingerprint)
+    level -= (float)bandMean;
+
+  return result;
+}
+
+float IRAnalysis::getLoudnessMatchGainDb() const {
+  if (energyDb <= -100.0f)
+    return 0.0f;
+
+  // Normalisation shifts every level by the same amount
+  float normalisedLoudness =
+      loudnessDb - energyDb + juce::Decibels::gainToDecibels(normalisedLevel);
+  return juce::jlimit(-maxMatchGainDb, maxMatchGainDb,
+                      matchTargetDb - normalisedLoudness);
+}
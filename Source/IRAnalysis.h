@@ -0,0 +1,45 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// IRAnalysis: level, tone and timing descriptors of one impulse response.
+//
+// The library scan measures every file once and keeps the result in the
+// index; the loader reuses it, or measures on the spot for a file the index
+// has not seen. Levels describe the IR as stored in the file, before the
+// convolver normalises it.
+//==============================================================================
+struct IRAnalysis {
+  float loudnessDb = -100.0f; // BS.1770 K-weighted, averaged over channels
+  float energyDb = -100.0f;   // Unweighted, loudest channel
+  float peak = 0.0f;
+  float spectralCentroidHz = 0.0f;
+  float effectiveLengthMs = 0.0f; // Until what is left is 60 dB down
+  float onsetMs = 0.0f;           // First sample within 20 dB of the peak
+
+  // Spectral fingerprint: band levels in dB over log-spaced bands from
+  // fingerprintLoHz to fingerprintHiHz, with the mean removed so only the
+  // shape counts. Similar-sounding IRs lie close in Euclidean distance.
+  static constexpr int numFingerprintBands = 24;
+  using Fingerprint = std::array<float, numFingerprintBands>;
+  Fingerprint fingerprint{};
+
+  static constexpr float fingerprintLoHz = 40.0f;
+  static constexpr float fingerprintHiHz = 16000.0f;
+
+  static IRAnalysis measure(const juce::AudioBuffer<float> &ir,
+                            double sampleRate);
+
+  // Gain that brings the IR to matchTargetDb once the convolver has
+  // normalised it to unit energy, limited to +/- maxMatchGainDb
+  float getLoudnessMatchGainDb() const;
+
+  // Roughly where a guitar cab IR lands after normalisation, so a typical
+  // IR barely moves and only the outliers are pulled in
+  static constexpr float matchTargetDb = -16.0f;
+  static constexpr float maxMatchGainDb = 12.0f;
+
+  // juce::dsp::Convolution scales the loudest channel to this much energy
+  static constexpr float normalisedLevel = 0.125f;
+};
@@ -0,0 +1,38 @@
+#include "IRAsset.h"
+
+IRAsset::Ptr IRAsset::create(const juce::File &file,
+                             juce::AudioBuffer<float> &&pcm,
+                             double sampleRate,
+                             const IRAnalysis *knownAnalysis) {
+  // The constructor is private, so no make_shared
+  return Ptr(new IRAsset(file, std::move(pcm), sampleRate, knownAnalysis));
+}
+
+IRAsset::IRAsset(const juce::File &f, juce::AudioBuffer<float> &&pcm,
+                 double rate, const IRAnalysis *knownAnalysis)
+    : file(f), buffer(std::move(pcm)), sampleRate(rate),
+      lengthSeconds(rate > 0.0 ? buffer.getNumSamples() / rate : 0.0),
+      contentHash(computeContentHash(buffer, rate)),
+      analysis(knownAnalysis != nullptr ? *knownAnalysis
+                                        : IRAnalysis::measure(buffer, rate)) {}
+
+uint64_t IRAsset::computeContentHash(const juce::AudioBuffer<float> &buffer,
+                                     double rate) {
+  // FNV-1a over the shape, the rate and the raw samples
+  uint64_t hash = 14695981039346656037ull;
+  auto mix = [&hash](const void *data, size_t size) {
+    auto *bytes = static_cast<const uint8_t *>(data);
+    for (size_t i = 0; i < size; ++i) {
+      hash ^= bytes[i];
+      hash *= 1099511628211ull;
+    }
+  };
+
+  int shape[2] = {buffer.getNumChannels(), buffer.getNumSamples()};
+  mix(shape, sizeof(shape));
+  mix(&rate, sizeof(rate));
+  for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    mix(buffer.getReadPointer(ch),
+        sizeof(float) * (size_t)buffer.getNumSamples());
+  return hash;
+}
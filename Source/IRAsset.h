@@ -0,0 +1,52 @@
+#pragma once
+
+#include "IRAnalysis.h"
+#include <JuceHeader.h>
+
+//==============================================================================
+// IRAsset: one decoded impulse response, immutable once created.
+//
+// Slots publish their current asset as a shared_ptr; the aligner, the baker,
+// the waveform view and the exporter each take a snapshot handle and read it
+// for as long as they like without copying. Loading a new IR publishes a new
+// asset rather than resizing the old buffer under a reader's feet, and the
+// last holder frees the old one.
+//==============================================================================
+class IRAsset {
+public:
+  using Ptr = std::shared_ptr<const IRAsset>;
+
+  // Takes ownership of the decoded samples and runs the analysis once;
+  // knownAnalysis (from the library index) saves measuring it again
+  static Ptr create(const juce::File &file, juce::AudioBuffer<float> &&pcm,
+                    double sampleRate,
+                    const IRAnalysis *knownAnalysis = nullptr);
+
+  const juce::File &getFile() const { return file; }
+  const juce::AudioBuffer<float> &getBuffer() const { return buffer; }
+  double getSampleRate() const { return sampleRate; }
+  double getLengthSeconds() const { return lengthSeconds; }
+
+  // Hash of the samples and rate; identifies the IR's content regardless of
+  // where the file lives
+  uint64_t getContentHash() const { return contentHash; }
+
+  const IRAnalysis &getAnalysis() const { return analysis; }
+
+  // The same hash for samples that never become an asset (library scan)
+  static uint64_t computeContentHash(const juce::AudioBuffer<float> &buffer,
+                                     double rate);
+
+private:
+  IRAsset(const juce::File &file, juce::AudioBuffer<float> &&pcm,
+          double sampleRate, const IRAnalysis *knownAnalysis);
+
+  const juce::File file;
+  const juce::AudioBuffer<float> buffer;
+  const double sampleRate;
+  const double lengthSeconds;
+  const uint64_t contentHash;
+  const IRAnalysis analysis;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(IRAsset)
+};
@@ -0,0 +1,474 @@
+#include "IRLibraryIndex.h"
+#include "AtomicFileWriter.h"
+#include "PresetManager.h"
+
+namespace {
+constexpr int fileMagic = 0x4c524946; // "FIRL"
+constexpr int fileVersion = 4;
+
+bool pathLess(const IRLibraryIndex::Entry &a, const IRLibraryIndex::Entry &b) {
+  return a.path < b.path;
+}
+
+// One folder's analysis, shared with its pool jobs so that none of them
+// outlives what it writes to
+struct AnalysisRun {
+  std::vector<IRLibraryIndex::Entry> found;
+  std::vector<size_t> changed;
+  std::vector<char> readable;
+  juce::CriticalSection doneLock;
+  std::vector<int> doneBatches; // Guarded by doneLock
+  juce::WaitableEvent batchDone;
+};
+} // namespace
+
+IRLibraryIndex::IRLibraryIndex()
+    : juce::Thread("FreeIR Library Scanner"),
+      snapshot(std::make_shared<const std::vector<Entry>>()),
+      indexFile(PresetManager::getDefaultRootFolder().getChildFile(
+          "IRLibrary.bin")),
+      analysisPool(juce::jlimit(1, 8, juce::SystemStats::getNumCpus() - 1)) {
+  watcher.onChange = [this](const juce::Array<juce::File> &paths) {
+    {
+      const juce::ScopedLock sl(queueLock);
+      for (auto &path : paths)
+        scanQueue.addIfNotAlreadyThere(path);
+    }
+    notify();
+  };
+
+  startThread(juce::Thread::Priority::low);
+}
+
+IRLibraryIndex::~IRLibraryIndex() {
+  // The jobs call back into this object, so they go before the scan does
+  signalThreadShouldExit();
+  notify();
+  analysisPool.removeAllJobs(true, 4000);
+  stopThread(4000);
+}
+
+bool IRLibraryIndex::findAnalysis(const juce::File &file,
+                                  IRAnalysis &result) const {
+  auto entries = getSnapshot();
+  auto *known = findEntry(*entries, file);
+  if (known == nullptr || !known->isAnalysed())
+    return false;
+
+  Entry onDisk;
+  onDisk.path = known->path;
+  onDisk.size = file.getSize();
+  onDisk.modifiedMs = file.getLastModificationTime().toMilliseconds();
+  if (!isUnchanged(*known, onDisk))
+    return false;
+
+  result = known->analysis;
+  return true;
+}
+
+std::vector<juce::File>
+IRLibraryIndex::findSimilar(const IRAnalysis::Fingerprint &query,
+                            int maxResults, const juce::File &exclude) const {
+  constexpr auto numBands = (size_t)IRAnalysis::numFingerprintBands;
+  auto table = std::atomic_load(&fingerprints);
+  if (table == nullptr || maxResults <= 0)
+    return {};
+
+  // Brute force: at 24 dimensions a tree prunes next to nothing, while the
+  // packed rows stream through the cache and the inner loop vectorises
+  const auto &entries = *table->entries;
+  auto *excluded = findEntry(entries, exclude);
+
+  std::vector<std::pair<float, size_t>> ranked;
+  ranked.reserve(entries.size());
+  const float *row = table->rows.data();
+  for (size_t i = 0; i < entries.size(); ++i, row += numBands) {
+    if (&entries[i] == excluded || !entries[i].isAnalysed())
+      continue;
+    float distance = 0.0f;
+    for (size_t b = 0; b < numBands; ++b) {
+      float d = row[b] - query[b];
+      distance += d * d;
+    }
+    ranked.push_back({distance, i});
+  }
+
+  auto count = juce::jmin((size_t)maxResults, ranked.size());
+  std::partial_sort(ranked.begin(), ranked.begin() + (std::ptrdiff_t)count,
+                    ranked.end());
+
+  std::vector<juce::File> files;
+  files.reserve(count);
+  for (size_t i = 0; i < count; ++i)
+    files.push_back(entries[ranked[i].second].getFile());
+  return files;
+}
+
+void IRLibraryIndex::requestScan(const juce::File &path) {
+  {
+    const juce::ScopedLock sl(queueLock);
+    scanQueue.addIfNotAlreadyThere(path);
+  }
+  notify();
+}
+
+void IRLibraryIndex::watchFolder(const juce::File &folder) {
+  if (watcher.watch(folder))
+    requestScan(folder);
+}
+
+std::pair<std::vector<IRLibraryIndex::Entry>::const_iterator,
+          std::vector<IRLibraryIndex::Entry>::const_iterator>
+IRLibraryIndex::findRange(const std::vector<Entry> &entries,
+                          const juce::File &folder) {
+  // Paths sharing a prefix are contiguous in sorted order
+  auto prefix = folder.getFullPathName() + juce::File::getSeparatorString();
+  Entry probe;
+  probe.path = prefix;
+  auto first = std::lower_bound(entries.begin(), entries.end(), probe,
+                                pathLess);
+  auto last = first;
+  while (last != entries.end() && last->path.startsWith(prefix))
+    ++last;
+  return {first, last};
+}
+
+const IRLibraryIndex::Entry *
+IRLibraryIndex::findEntry(const std::vector<Entry> &entries,
+                          const juce::File &file) {
+  Entry probe;
+  probe.path = file.getFullPathName();
+  auto known = std::lower_bound(entries.begin(), entries.end(), probe,
+                                pathLess);
+  return known != entries.end() && known->path == probe.path ? &*known
+                                                             : nullptr;
+}
+
+void IRLibraryIndex::describe(Entry &entry) {
+  // Pooled: packs reuse the same names ("SM57.wav") and details over and over
+  auto &pool = juce::StringPool::getGlobalPool();
+  auto name = juce::File(entry.path).getFileName();
+  entry.name = pool.getPooledString(name);
+  entry.searchName = pool.getPooledString(name.toLowerCase());
+
+  juce::String details;
+  if (entry.sampleRate > 0.0) {
+    double kHz = entry.sampleRate / 1000.0;
+    details << (kHz == std::floor(kHz) ? juce::String((int)kHz)
+                                       : juce::String(kHz, 1))
+            << " kHz  " << juce::roundToInt(entry.getLengthMs()) << " ms  "
+            << juce::String(entry.analysis.loudnessDb, 1) << " LU";
+  }
+  entry.details = pool.getPooledString(details);
+}
+
+bool IRLibraryIndex::isUnchanged(const Entry &known, const Entry &onDisk) {
+  return known.path == onDisk.path && known.size == onDisk.size &&
+         known.modifiedMs == onDisk.modifiedMs;
+}
+
+//==============================================================================
+void IRLibraryIndex::run() {
+  loadFromDisk();
+  sendChangeMessage();
+
+  while (!threadShouldExit()) {
+    juce::Array<juce::File> paths;
+    {
+      const juce::ScopedLock sl(queueLock);
+      paths.swapWith(scanQueue);
+    }
+
+    if (paths.isEmpty()) {
+      wait(-1);
+      continue;
+    }
+
+    // Everything queued so far is applied to one copy and published once
+    // it is complete; folders being decoded publish their progress as well
+    auto entries = *getSnapshot();
+    bool changed = false;
+    for (auto &path : paths) {
+      if (threadShouldExit())
+        return;
+      changed = refreshPath(path, entries) || changed;
+    }
+
+    if (changed && !threadShouldExit()) {
+      auto published =
+          std::make_shared<const std::vector<Entry>>(std::move(entries));
+      publish(published);
+      saveToDisk(*published);
+      sendChangeMessage();
+    }
+  }
+}
+
+bool IRLibraryIndex::refreshPath(const juce::File &path,
+                                 std::vector<Entry> &entries) {
+  if (path.isDirectory())
+    return scanFolder(path, entries);
+
+  Entry onDisk;
+  onDisk.path = path.getFullPathName();
+  auto known = std::lower_bound(entries.begin(), entries.end(), onDisk,
+                                pathLess);
+  bool isKnown = known != entries.end() && known->path == onDisk.path;
+
+  if (path.existsAsFile() &&
+      juce::WildcardFileFilter(fileWildcard, {}, {}).isFileSuitable(path)) {
+    onDisk.size = path.getSize();
+    onDisk.modifiedMs = path.getLastModificationTime().toMilliseconds();
+    if (isKnown && known->isAnalysed() && isUnchanged(*known, onDisk))
+      return false;
+
+    if (!analyse(onDisk)) {
+      if (isKnown)
+        entries.erase(known);
+      return isKnown;
+    }
+
+    if (isKnown)
+      *known = std::move(onDisk);
+    else
+      entries.insert(known, std::move(onDisk));
+    return true;
+  }
+
+  // Gone: drop the file, or everything that was below the folder
+  if (isKnown) {
+    entries.erase(known);
+    return true;
+  }
+  auto [first, last] = findRange(entries, path);
+  if (first == last)
+    return false;
+  entries.erase(first, last);
+  return true;
+}
+
+bool IRLibraryIndex::scanFolder(const juce::File &folder,
+                                std::vector<Entry> &entries) {
+  auto [first, last] = findRange(entries, folder);
+
+  // 1. Walk the tree; files whose size and mtime match keep their entry
+  auto run = std::make_shared<AnalysisRun>();
+  auto &found = run->found;
+  bool anyChanged = false;
+  for (const auto &item : juce::RangedDirectoryIterator(
+           folder, true, fileWildcard, juce::File::findFiles)) {
+    if (threadShouldExit())
+      return false;
+
+    Entry entry;
+    entry.path = item.getFile().getFullPathName();
+    entry.size = item.getFileSize();
+    entry.modifiedMs = item.getModificationTime().toMilliseconds();
+
+    auto known = std::lower_bound(first, last, entry, pathLess);
+    if (known != last && known->isAnalysed() && isUnchanged(*known, entry)) {
+      found.push_back(*known);
+    } else {
+      describe(entry);
+      found.push_back(std::move(entry));
+      anyChanged = true;
+    }
+  }
+
+  if (!anyChanged && found.size() == (size_t)std::distance(first, last))
+    return false;
+
+  // 2. Splice the folder's entries in place of its old ones and publish
+  // straight away: new and changed files are listed by name while the
+  // analysis fills them in
+  std::sort(found.begin(), found.end(), pathLess);
+  auto &changed = run->changed;
+  for (size_t i = 0; i < found.size(); ++i)
+    if (!found[i].isAnalysed())
+      changed.push_back(i);
+
+  auto at = entries.erase(first, last);
+  auto offset = (size_t)std::distance(entries.begin(), at);
+  entries.insert(at, found.begin(), found.end());
+  if (changed.empty())
+    return true;
+  publish(std::make_shared<const std::vector<Entry>>(entries));
+  sendChangeMessage();
+
+  // 3. Decode only the new and changed files, in batches on the pool
+  auto &readable = run->readable;
+  readable.assign(found.size(), 1);
+  int numBatches =
+      ((int)changed.size() + analysisBatchSize - 1) / analysisBatchSize;
+
+  for (int b = 0; b < numBatches; ++b) {
+    analysisPool.addJob([this, b, run] {
+      size_t end = juce::jmin(run->changed.size(),
+                              (size_t)(b + 1) * (size_t)analysisBatchSize);
+      for (size_t c = (size_t)b * analysisBatchSize; c < end; ++c) {
+        if (threadShouldExit())
+          break;
+        auto i = run->changed[c];
+        run->readable[i] = analyse(run->found[i]) ? 1 : 0;
+      }
+      {
+        const juce::ScopedLock sl(run->doneLock);
+        run->doneBatches.push_back(b);
+      }
+      run->batchDone.signal();
+    });
+  }
+
+  // 4. Move finished batches into place, republishing now and then so the
+  // browser fills in while the rest is still being decoded
+  auto lastPublishMs = juce::Time::getMillisecondCounter();
+  for (int numDone = 0; numDone < numBatches;) {
+    // Jobs removed on shutdown never signal, so the wait has to time out
+    if (threadShouldExit())
+      return false;
+    run->batchDone.wait((int)progressIntervalMs);
+    std::vector<int> batches;
+    {
+      const juce::ScopedLock sl(run->doneLock);
+      batches.swap(run->doneBatches);
+    }
+
+    for (int b : batches) {
+      size_t end = juce::jmin(changed.size(),
+                              (size_t)(b + 1) * (size_t)analysisBatchSize);
+      for (size_t c = (size_t)b * analysisBatchSize; c < end; ++c)
+        if (readable[changed[c]] != 0)
+          entries[offset + changed[c]] = std::move(found[changed[c]]);
+    }
+    numDone += (int)batches.size();
+
+    auto now = juce::Time::getMillisecondCounter();
+    if (numDone < numBatches && !threadShouldExit() &&
+        now - lastPublishMs >= progressIntervalMs) {
+      publish(std::make_shared<const std::vector<Entry>>(entries));
+      sendChangeMessage();
+      lastPublishMs = now;
+    }
+  }
+
+  if (threadShouldExit())
+    return false;
+
+  // 5. Files that turned out not to be audio leave the index
+  for (auto c = changed.rbegin(); c != changed.rend(); ++c)
+    if (readable[*c] == 0)
+      entries.erase(entries.begin() + (std::ptrdiff_t)(offset + *c));
+  return true;
+}
+
+bool IRLibraryIndex::analyse(Entry &entry) {
+  auto reader = formats->createReaderFor(entry.getFile());
+  if (reader == nullptr || reader->lengthInSamples <= 0 ||
+      reader->lengthInSamples > std::numeric_limits<int>::max())
+    return false;
+
+  entry.numChannels = (int)reader->numChannels;
+  entry.sampleRate = reader->sampleRate;
+  entry.lengthInSamples = reader->lengthInSamples;
+
+  juce::AudioBuffer<float> pcm(entry.numChannels, (int)entry.lengthInSamples);
+  reader->read(&pcm, 0, pcm.getNumSamples(), 0, true, true);
+  entry.contentHash = IRAsset::computeContentHash(pcm, entry.sampleRate);
+  entry.analysis = IRAnalysis::measure(pcm, entry.sampleRate);
+  entry.thumbnail = IRThumbnail::create(
+      pcm, juce::jmax(1, (int)std::ceil(entry.analysis.effectiveLengthMs *
+                                        entry.sampleRate / 1000.0)));
+  describe(entry);
+  return true;
+}
+
+//==============================================================================
+void IRLibraryIndex::loadFromDisk() {
+  juce::FileInputStream in(indexFile);
+  if (!in.openedOk() || in.readInt() != fileMagic ||
+      in.readInt() != fileVersion)
+    return;
+
+  // Every entry takes at least this many bytes, so a count the rest of
+  // the file cannot hold means the file is damaged
+  constexpr juce::int64 minEntryBytes =
+      1 + 3 * 8 + 4 + 8 + 8 + 6 * 4 + IRAnalysis::numFingerprintBands * 4 +
+      4 + IRThumbnail::totalColumns * 2;
+  int count = in.readInt();
+  if (count < 0 || count > in.getNumBytesRemaining() / minEntryBytes)
+    return;
+
+  auto entries = std::make_shared<std::vector<Entry>>();
+  entries->reserve((size_t)count);
+  for (int i = 0; i < count && !in.isExhausted(); ++i) {
+    Entry entry;
+    entry.path = in.readString();
+    entry.size = in.readInt64();
+    entry.modifiedMs = in.readInt64();
+    entry.numChannels = in.readInt();
+    entry.sampleRate = in.readDouble();
+    entry.lengthInSamples = in.readInt64();
+    entry.contentHash = (uint64_t)in.readInt64();
+    auto &analysis = entry.analysis;
+    analysis.loudnessDb = in.readFloat();
+    analysis.energyDb = in.readFloat();
+    analysis.peak = in.readFloat();
+    analysis.spectralCentroidHz = in.readFloat();
+    analysis.effectiveLengthMs = in.readFloat();
+    analysis.onsetMs = in.readFloat();
+    for (auto &level : analysis.fingerprint)
+      level = in.readFloat();
+    entry.thumbnail.length = in.readInt();
+    in.read(entry.thumbnail.peaks.data(), (int)entry.thumbnail.peaks.size());
+    describe(entry);
+    entries->push_back(std::move(entry));
+  }
+
+  std::sort(entries->begin(), entries->end(), pathLess);
+  publish(entries);
+}
+
+void IRLibraryIndex::publish(
+    std::shared_ptr<const std::vector<Entry>> entries) {
+  constexpr auto numBands = (size_t)IRAnalysis::numFingerprintBands;
+
+  auto table = std::make_shared<FingerprintTable>();
+  table->entries = entries;
+  table->rows.resize(entries->size() * numBands);
+  for (size_t i = 0; i < entries->size(); ++i)
+    std::copy((*entries)[i].analysis.fingerprint.begin(),
+              (*entries)[i].analysis.fingerprint.end(),
+              table->rows.begin() + (std::ptrdiff_t)(i * numBands));
+
+  std::atomic_store(&snapshot, Snapshot(entries));
+  std::atomic_store(&fingerprints,
+                    std::shared_ptr<const FingerprintTable>(table));
+}
+
+void IRLibraryIndex::saveToDisk(const std::vector<Entry> &entries) const {
+  AtomicFileWriter::write(indexFile, [&entries](juce::OutputStream &out) {
+    out.writeInt(fileMagic);
+    out.writeInt(fileVersion);
+    out.writeInt((int)entries.size());
+    for (const auto &entry : entries) {
+      out.writeString(entry.path);
+      out.writeInt64(entry.size);
+      out.writeInt64(entry.modifiedMs);
+      out.writeInt(entry.numChannels);
+      out.writeDouble(entry.sampleRate);
+      out.writeInt64(entry.lengthInSamples);
+      out.writeInt64((juce::int64)entry.contentHash);
+      const auto &analysis = entry.analysis;
+      out.writeFloat(analysis.loudnessDb);
+      out.writeFloat(analysis.energyDb);
+      out.writeFloat(analysis.peak);
+      out.writeFloat(analysis.spectralCentroidHz);
+      out.writeFloat(analysis.effectiveLengthMs);
+      out.writeFloat(analysis.onsetMs);
+      for (auto level : analysis.fingerprint)
+        out.writeFloat(level);
+      out.writeInt(entry.thumbnail.length);
+      out.write(entry.thumbnail.peaks.data(), entry.thumbnail.peaks.size());
+    }
+  });
+}
@@ -0,0 +1,143 @@
+#pragma once
+
+#include "FolderWatcher.h"
+#include "IRLoader.h"
+#include "IRThumbnail.h"
+#include <JuceHeader.h>
+
+//==============================================================================
+// IRLibraryIndex: what is known about every IR file under the scanned
+// folders, kept in memory and in a compact binary file: format, content
+// hash, the IRAnalysis descriptors and a waveform thumbnail.
+//
+// Scans run in the background: one thread walks the folder tree and stats
+// each file, and only files that are new or whose size or modification
+// time changed are decoded, spread over a thread pool. Results are
+// published as immutable, path-sorted snapshots, so the browser can list
+// any folder straight from memory: a new folder shows up by name as soon as
+// it has been walked, and its analysis fills in as the decodes finish.
+// Watched folders are scanned once and then kept current from change
+// notifications, without rescanning the tree.
+// Shared by all plugin instances through
+// juce::SharedResourcePointer<IRLibraryIndex>; listeners hear about every
+// published snapshot on the message thread.
+//==============================================================================
+class IRLibraryIndex : private juce::Thread, public juce::ChangeBroadcaster {
+public:
+  IRLibraryIndex();
+  ~IRLibraryIndex() override;
+
+  struct Entry {
+    juce::String path;
+    juce::int64 size = 0;
+    juce::int64 modifiedMs = 0;
+    int numChannels = 0;
+    double sampleRate = 0.0;
+    juce::int64 lengthInSamples = 0;
+    uint64_t contentHash = 0; // Same value as IRAsset::getContentHash()
+    IRAnalysis analysis;
+    IRThumbnail thumbnail; // Drawn by the browser in place of the file
+
+    // Display strings, made once when the entry is created and pooled, so
+    // the browser never formats anything while painting or searching
+    juce::String name;       // File name
+    juce::String searchName; // Lower-case name, matched against queries
+    juce::String details;    // "48 kHz  250 ms  -16.2 LU"
+
+    // False while a scan has only listed the file; the format,
+    // measurements and thumbnail are filled in when it has been decoded
+    bool isAnalysed() const { return sampleRate > 0.0; }
+
+    juce::File getFile() const { return juce::File(path); }
+    double getLengthMs() const {
+      return sampleRate > 0.0 ? 1000.0 * lengthInSamples / sampleRate : 0.0;
+    }
+  };
+
+  // Sorted by path, never modified once published
+  using Snapshot = std::shared_ptr<const std::vector<Entry>>;
+
+  // Any thread
+  Snapshot getSnapshot() const { return std::atomic_load(&snapshot); }
+
+  // Range of entries whose path lies under folder
+  static std::pair<std::vector<Entry>::const_iterator,
+                   std::vector<Entry>::const_iterator>
+  findRange(const std::vector<Entry> &entries, const juce::File &folder);
+
+  // The entry for file, or null
+  static const Entry *findEntry(const std::vector<Entry> &entries,
+                                const juce::File &file);
+
+  // Fills the display strings from the path and the measurements
+  static void describe(Entry &entry);
+
+  // Any thread: the stored analysis of a file, if the index holds it and
+  // the file has not changed since
+  bool findAnalysis(const juce::File &file, IRAnalysis &result) const;
+
+  // Any thread: up to maxResults indexed IRs whose fingerprints lie
+  // closest to the given one, nearest first, leaving out the file exclude
+  std::vector<juce::File> findSimilar(const IRAnalysis::Fingerprint &query,
+                                      int maxResults,
+                                      const juce::File &exclude = {}) const;
+
+  // Any thread: queue a rescan of a folder tree or a single file; paths that
+  // no longer exist leave the index. Repeated requests collapse into one.
+  void requestScan(const juce::File &path);
+
+  // Any thread: scan a folder tree once, then follow its changes
+  void watchFolder(const juce::File &folder);
+
+  // Extensions the browser and the scanner consider IRs
+  static constexpr const char *fileWildcard = "*.wav;*.aif;*.aiff";
+
+private:
+  void run() override;
+
+  // Scan thread: makes entries current, with a fingerprint table to match
+  void publish(std::shared_ptr<const std::vector<Entry>> entries);
+
+  void loadFromDisk();
+  void saveToDisk(const std::vector<Entry> &entries) const;
+
+  // Bring entries up to date for one path; false if nothing changed
+  bool scanFolder(const juce::File &folder, std::vector<Entry> &entries);
+  bool refreshPath(const juce::File &path, std::vector<Entry> &entries);
+
+  // Decodes one file; false if it cannot be read as audio
+  bool analyse(Entry &entry);
+
+  // Whether both entries describe the same file version
+  static bool isUnchanged(const Entry &known, const Entry &onDisk);
+
+  Snapshot snapshot; // Published with std::atomic_store
+
+  // Every entry's fingerprint packed row by row, so a similarity query is one
+  // linear pass over contiguous floats. Keeps its own entries snapshot so the
+  // rows always line up.
+  struct FingerprintTable {
+    Snapshot entries;
+    std::vector<float> rows;
+  };
+  std::shared_ptr<const FingerprintTable> fingerprints; // std::atomic_store
+  juce::File indexFile;
+
+  juce::CriticalSection queueLock;
+  juce::Array<juce::File> scanQueue;
+
+  juce::ThreadPool analysisPool;
+  juce::SharedResourcePointer<SharedAudioFormats> formats;
+
+  // Files are handed to the pool in batches of this many; a batch is
+  // decoded and measured in one go on one core
+  static constexpr int analysisBatchSize = 32;
+
+  // While a folder is being decoded, its progress is published this often
+  static constexpr juce::uint32 progressIntervalMs = 500;
+
+  // Declared last so it stops before anything its callback touches
+  FolderWatcher watcher;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(IRLibraryIndex)
+};
@@ -0,0 +1,212 @@
+#include "IRListQuery.h"
+
+#include <cstring>
+#include <numeric>
+
+IRListQuery::IRListQuery() : juce::Thread("FreeIR List Query") {
+  startThread(juce::Thread::Priority::normal);
+}
+
+IRListQuery::~IRListQuery() {
+  cancelPendingUpdate();
+  signalThreadShouldExit();
+  notify();
+  stopThread(4000);
+}
+
+IRListQuery::Items
+IRListQuery::makeFolderItems(IRLibraryIndex::Snapshot snapshot,
+                             const juce::File &folder) {
+  auto list = std::make_shared<ItemList>();
+  auto [first, last] = IRLibraryIndex::findRange(*snapshot, folder);
+  list->items.reserve((size_t)std::distance(first, last));
+  for (auto it = first; it != last; ++it)
+    list->items.push_back(&*it);
+  list->snapshot = std::move(snapshot);
+  return list;
+}
+
+IRListQuery::Items
+IRListQuery::makeItems(IRLibraryIndex::Snapshot snapshot,
+                       const std::vector<juce::File> &files) {
+  auto list = std::make_shared<ItemList>();
+
+  // Stand-ins first, so pointers into extras stay put
+  std::vector<const IRLibraryIndex::Entry *> known(files.size());
+  for (size_t i = 0; i < files.size(); ++i) {
+    known[i] = IRLibraryIndex::findEntry(*snapshot, files[i]);
+    if (known[i] == nullptr) {
+      IRLibraryIndex::Entry entry;
+      entry.path = files[i].getFullPathName();
+      IRLibraryIndex::describe(entry);
+      list->extras.push_back(std::move(entry));
+    }
+  }
+
+  size_t nextExtra = 0;
+  list->items.reserve(files.size());
+  for (auto *entry : known)
+    list->items.push_back(entry != nullptr ? entry
+                                           : &list->extras[nextExtra++]);
+  list->snapshot = std::move(snapshot);
+  return list;
+}
+
+void IRListQuery::request(Items items, const juce::String &query,
+                          SortOrder order) {
+  {
+    const juce::ScopedLock sl(lock);
+    pending = {std::move(items), query.trim().toLowerCase(), order};
+    hasPending = true;
+    ++requestGeneration;
+  }
+  notify();
+}
+
+int IRListQuery::fuzzyScore(const char *pattern, const char *text) {
+  auto isWordStart = [text](const char *c) {
+    return c == text || c[-1] == ' ' || c[-1] == '_' || c[-1] == '-' ||
+           c[-1] == '.' || c[-1] == '(';
+  };
+
+  int score = 0;
+  const char *previous = nullptr; // Where the last pattern character matched
+  const char *t = text;
+  for (const char *p = pattern; *p != 0; ++p) {
+    while (*t != 0 && *t != *p)
+      ++t;
+    if (*t == 0)
+      return -1;
+
+    score += 1;
+    if (isWordStart(t))
+      score += 8;
+    if (previous != nullptr && t == previous + 1)
+      score += 4;
+    previous = t++;
+  }
+  return score;
+}
+
+//==============================================================================
+void IRListQuery::run() {
+  while (!threadShouldExit()) {
+    Request job;
+    uint32_t generation = 0;
+    {
+      const juce::ScopedLock sl(lock);
+      if (hasPending) {
+        job = std::move(pending);
+        hasPending = false;
+        generation = requestGeneration;
+      }
+    }
+
+    if (job.items == nullptr) {
+      wait(-1);
+      continue;
+    }
+
+    std::vector<int> rows;
+    if (!process(job, generation, rows))
+      continue;
+
+    {
+      const juce::ScopedLock sl(lock);
+      if (isStale(generation))
+        continue;
+      resultItems = std::move(job.items);
+      resultRows = std::move(rows);
+    }
+    triggerAsyncUpdate();
+  }
+}
+
+void IRListQuery::handleAsyncUpdate() {
+  Items items;
+  std::vector<int> rows;
+  {
+    const juce::ScopedLock sl(lock);
+    items = std::move(resultItems);
+    rows = std::move(resultRows);
+  }
+
+  if (items != nullptr && onResult)
+    onResult(std::move(items), std::move(rows));
+}
+
+bool IRListQuery::process(const Request &job, uint32_t generation,
+                          std::vector<int> &rows) {
+  const auto &items = job.items->items;
+  std::vector<int> scores;
+
+  // 1. Filter; a query that extends the last one only revisits its matches
+  if (job.query.isEmpty()) {
+    rows.resize(items.size());
+    std::iota(rows.begin(), rows.end(), 0);
+  } else {
+    bool refine = job.items == lastItems && lastQuery.isNotEmpty() &&
+                  job.query.startsWith(lastQuery);
+    int numCandidates = refine ? (int)lastMatches.size() : (int)items.size();
+    auto *pattern = job.query.toRawUTF8();
+
+    scores.resize(items.size());
+    for (int c = 0; c < numCandidates; ++c) {
+      if (c % checkInterval == 0 && isStale(generation))
+        return false;
+
+      int row = refine ? lastMatches[(size_t)c] : c;
+      auto *name = items[(size_t)row]->searchName.toRawUTF8();
+      int score = fuzzyScore(pattern, name);
+      if (score >= 0) {
+        rows.push_back(row);
+        scores[(size_t)row] = score;
+      }
+    }
+
+    lastItems = job.items;
+    lastQuery = job.query;
+    lastMatches = rows;
+  }
+
+  if (isStale(generation))
+    return false;
+
+  // 2. Sort: best matches first while searching, then by the chosen order
+  auto byOrder = [&](int a, int b) {
+    const auto &x = *items[(size_t)a];
+    const auto &y = *items[(size_t)b];
+    switch (job.order) {
+    case SortOrder::length:
+      if (x.getLengthMs() != y.getLengthMs())
+        return x.getLengthMs() < y.getLengthMs();
+      break;
+    case SortOrder::loudness:
+      if (x.analysis.loudnessDb != y.analysis.loudnessDb)
+        return x.analysis.loudnessDb > y.analysis.loudnessDb;
+      break;
+    case SortOrder::date:
+      if (x.modifiedMs != y.modifiedMs)
+        return x.modifiedMs > y.modifiedMs;
+      break;
+    case SortOrder::listed:
+      return a < b;
+    case SortOrder::name:
+      break;
+    }
+    return std::strcmp(x.searchName.toRawUTF8(), y.searchName.toRawUTF8()) <
+           0;
+  };
+
+  if (scores.empty()) {
+    std::sort(rows.begin(), rows.end(), byOrder);
+  } else {
+    std::sort(rows.begin(), rows.end(), [&](int a, int b) {
+      if (scores[(size_t)a] != scores[(size_t)b])
+        return scores[(size_t)a] > scores[(size_t)b];
+      return byOrder(a, b);
+    });
+  }
+
+  return !isStale(generation);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "IRLibraryIndex.h"
+#include <JuceHeader.h>
+
+//==============================================================================
+// IRListQuery: filters and sorts the browser's rows on a background thread.
+//
+// The browser hands over an immutable item list, a search string and a sort
+// order; the worker fuzzy-matches the names, sorts, and posts the row order
+// back to the message thread. A newer request abandons the one in flight,
+// and a query that only extends the previous one searches just the previous
+// matches, so each keystroke does less work than the one before.
+//==============================================================================
+class IRListQuery : private juce::Thread, private juce::AsyncUpdater {
+public:
+  IRListQuery();
+  ~IRListQuery() override;
+
+  // The rows on offer: index entries, kept alive by the snapshot, plus
+  // stand-ins for files the index does not hold (a playlist item elsewhere)
+  struct ItemList {
+    IRLibraryIndex::Snapshot snapshot;
+    std::vector<IRLibraryIndex::Entry> extras;
+    std::vector<const IRLibraryIndex::Entry *> items;
+  };
+  using Items = std::shared_ptr<const ItemList>;
+
+  // Every indexed IR below folder
+  static Items makeFolderItems(IRLibraryIndex::Snapshot snapshot,
+                               const juce::File &folder);
+
+  // Files in the given order, taking entries from the snapshot where it can
+  static Items makeItems(IRLibraryIndex::Snapshot snapshot,
+                         const std::vector<juce::File> &files);
+
+  // listed keeps the order the items came in (ranked results, playlists)
+  enum class SortOrder { name, length, loudness, date, listed };
+
+  // Message thread
+  void request(Items items, const juce::String &query, SortOrder order);
+
+  // Message thread: the latest completed request; rows index items->items
+  std::function<void(Items items, std::vector<int> rows)> onResult;
+
+  // Fuzzy subsequence match of a lower-case pattern against lower-case text:
+  // -1 if some pattern character is missing, otherwise higher for matches
+  // at word starts and in runs
+  static int fuzzyScore(const char *pattern, const char *text);
+
+private:
+  void run() override;
+  void handleAsyncUpdate() override;
+
+  struct Request {
+    Items items;
+    juce::String query;
+    SortOrder order = SortOrder::name;
+  };
+
+  // Worker thread; false if a newer request came in meanwhile
+  bool process(const Request &job, uint32_t generation,
+               std::vector<int> &rows);
+  bool isStale(uint32_t generation) const {
+    return generation != requestGeneration || threadShouldExit();
+  }
+
+  juce::CriticalSection lock;
+  Request pending; // Guarded by lock, as are the two results below
+  bool hasPending = false;
+  std::atomic<uint32_t> requestGeneration{0};
+
+  Items resultItems;
+  std::vector<int> resultRows;
+
+  // Worker thread: the last finished search, for incremental refinement
+  Items lastItems;
+  juce::String lastQuery;
+  std::vector<int> lastMatches;
+
+  // How often a long pass checks whether it has been overtaken
+  static constexpr int checkInterval = 4096;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(IRListQuery)
+};
@@ -0,0 +1,210 @@
+#include "IRLoader.h"
+#include "IRLibraryIndex.h"
+#include "IRSlot.h"
+
+std::unique_ptr<juce::AudioFormatReader>
+SharedAudioFormats::createReaderFor(const juce::File &file) {
+  auto extension = file.getFileExtension();
+  if (auto *format = manager.findFormatForFileExtension(extension)) {
+    std::unique_ptr<juce::MemoryMappedAudioFormatReader> mapped(
+        format->createMemoryMappedReader(file));
+    if (mapped != nullptr && mapped->mapEntireFile())
+      return mapped;
+  }
+  return std::unique_ptr<juce::AudioFormatReader>(
+      manager.createReaderFor(file));
+}
+
+//==============================================================================
+IRLoader::IRLoader(std::array<IRSlot, 4> &s)
+    : juce::Thread("FreeIR IR Loader"), slots(s) {}
+
+IRLoader::~IRLoader() {
+  signalThreadShouldExit();
+  notify();
+  stopThread(4000);
+}
+
+void IRLoader::requestLoad(int slotIndex, const juce::File &file,
+                           IRAsset::Ptr decoded) {
+  auto modifiedMs = file.getLastModificationTime().toMilliseconds();
+  {
+    const juce::ScopedLock sl(lock);
+    auto &request = requests[(size_t)slotIndex];
+    request.file = file;
+    ++request.serial;
+    request.pending = true;
+
+    // Decoded or preloaded: the thread only builds the kernel and publishes
+    if (decoded == nullptr)
+      decoded = findPreloaded(file, modifiedMs);
+    request.decoded = std::move(decoded);
+  }
+
+  if (!isThreadRunning())
+    startThread(juce::Thread::Priority::normal);
+  notify();
+}
+
+void IRLoader::cancel(int slotIndex) {
+  const juce::ScopedLock sl(lock);
+  auto &request = requests[(size_t)slotIndex];
+  request.pending = false;
+  request.decoded = nullptr;
+  ++request.serial;
+}
+
+void IRLoader::preload(int slotIndex, std::vector<juce::File> files) {
+  {
+    const juce::ScopedLock sl(lock);
+    preloadWanted[(size_t)slotIndex] = std::move(files);
+    preloaded.erase(std::remove_if(preloaded.begin(), preloaded.end(),
+                                   [this](const Preloaded &p) {
+                                     return !isWanted(p.file);
+                                   }),
+                    preloaded.end());
+  }
+
+  if (!isThreadRunning())
+    startThread(juce::Thread::Priority::normal);
+  notify();
+}
+
+IRAsset::Ptr IRLoader::findPreloaded(const juce::File &file,
+                                     juce::int64 modifiedMs) const {
+  for (auto &p : preloaded)
+    if (p.file == file && p.modifiedMs == modifiedMs)
+      return p.asset;
+  return nullptr;
+}
+
+void IRLoader::addPreloaded(const juce::File &file, juce::int64 modifiedMs,
+                            IRAsset::Ptr asset) {
+  if (!isWanted(file))
+    return;
+  if (asset != nullptr && asset->getLengthSeconds() > maxPreloadSeconds)
+    asset = nullptr;
+
+  for (auto &p : preloaded) {
+    if (p.file == file) {
+      p = {file, modifiedMs, std::move(asset)};
+      return;
+    }
+  }
+  preloaded.push_back({file, modifiedMs, std::move(asset)});
+}
+
+bool IRLoader::isWanted(const juce::File &file) const {
+  for (auto &files : preloadWanted)
+    if (std::find(files.begin(), files.end(), file) != files.end())
+      return true;
+  return false;
+}
+
+juce::File IRLoader::findFileToPreload() const {
+  // Nearest first across all slots, so every slot's next step is ready
+  // before anyone's second
+  size_t longest = 0;
+  for (auto &files : preloadWanted)
+    longest = juce::jmax(longest, files.size());
+
+  for (size_t i = 0; i < longest; ++i) {
+    for (auto &files : preloadWanted) {
+      if (i >= files.size())
+        continue;
+      auto known = std::find_if(
+          preloaded.begin(), preloaded.end(),
+          [&](const Preloaded &p) { return p.file == files[i]; });
+      if (known == preloaded.end())
+        return files[i];
+    }
+  }
+  return {};
+}
+
+//==============================================================================
+void IRLoader::run() {
+  while (!threadShouldExit()) {
+    // Take the next pending request, round-robin so one slot being clicked
+    // through cannot starve the others; with none waiting, preload
+    int slotIndex = -1;
+    juce::File file;
+    IRAsset::Ptr asset;
+    uint32_t serial = 0;
+    {
+      const juce::ScopedLock sl(lock);
+      for (int n = 0; n < (int)requests.size(); ++n) {
+        int i = (nextSlotToServe + n) % (int)requests.size();
+        auto &request = requests[(size_t)i];
+        if (request.pending) {
+          request.pending = false;
+          slotIndex = i;
+          file = request.file;
+          asset = std::move(request.decoded);
+          serial = request.serial;
+          nextSlotToServe = (i + 1) % (int)requests.size();
+          break;
+        }
+      }
+      if (slotIndex < 0)
+        file = findFileToPreload();
+    }
+
+    if (file == juce::File()) {
+      wait(-1);
+      continue;
+    }
+
+    if (asset == nullptr) {
+      auto modifiedMs = file.getLastModificationTime().toMilliseconds();
+      asset = decode(file);
+
+      const juce::ScopedLock sl(lock);
+      addPreloaded(file, modifiedMs, asset);
+    }
+    if (slotIndex < 0)
+      continue;
+
+    // The copy and gain are the costly part, so they happen unlocked; a
+    // request that overtakes this one meanwhile just wastes the kernel
+    auto &slot = slots[(size_t)slotIndex];
+    juce::AudioBuffer<float> kernel;
+    float kernelGain = 1.0f;
+    if (asset != nullptr) {
+      kernelGain = slot.getLiveKernelGain(*asset);
+      kernel = IRSlot::makeLiveKernel(*asset, kernelGain);
+    }
+
+    bool published = false;
+    {
+      // Publish only if nothing newer arrived for this slot meanwhile; the
+      // convolver only queues the kernel, so this part is short
+      const juce::ScopedLock sl(lock);
+      if (requests[(size_t)slotIndex].serial == serial &&
+          !threadShouldExit()) {
+        slot.setDecodedIR(std::move(asset), std::move(kernel), kernelGain);
+        published = true;
+      }
+    }
+
+    if (published)
+      sendChangeMessage();
+  }
+}
+
+IRAsset::Ptr IRLoader::decode(const juce::File &file) {
+  auto reader = formats->createReaderFor(file);
+  if (reader == nullptr || reader->lengthInSamples <= 0)
+    return nullptr;
+
+  // From a mapped reader this is the only pass over the data: samples are
+  // converted from the mapped pages straight into the asset's buffer
+  juce::AudioBuffer<float> pcm((int)reader->numChannels,
+                               (int)reader->lengthInSamples);
+  reader->read(&pcm, 0, (int)reader->lengthInSamples, 0, true, true);
+
+  IRAnalysis known;
+  bool isKnown = libraryIndex->findAnalysis(file, known);
+  return IRAsset::create(file, std::move(pcm), reader->sampleRate,
+                         isKnown ? &known : nullptr);
+}
@@ -0,0 +1,105 @@
+#pragma once
+
+#include "IRAsset.h"
+#include <JuceHeader.h>
+
+class IRLibraryIndex;
+class IRSlot;
+
+//==============================================================================
+// One registered AudioFormatManager for everything that decodes IR files;
+// share it through juce::SharedResourcePointer<SharedAudioFormats>.
+//==============================================================================
+struct SharedAudioFormats {
+  SharedAudioFormats() { manager.registerBasicFormats(); }
+
+  // Memory-mapped reader where the format has one (WAV, AIFF), so reads
+  // come straight from the page cache and only touched pages hit the disk;
+  // a regular stream reader otherwise. Null if the file can't be read.
+  std::unique_ptr<juce::AudioFormatReader>
+  createReaderFor(const juce::File &file);
+
+  juce::AudioFormatManager manager;
+};
+
+//==============================================================================
+// IRLoader: decodes IR files for the slots on a background thread.
+//
+// Each file is read once. The decoded asset is published to the slot,
+// whose convolver, the waveform view and the aligner all use it. Each slot
+// keeps at most one pending request, and a newer request replaces it: ten
+// quick clicks on "next" decode the IR in flight (if any) and the last one,
+// and a result that was overtaken while decoding is dropped. Listeners get a
+// change message on the message thread after every publish.
+//
+// When no request is waiting, the thread preloads the files each slot is
+// likely to step to next into a small cache. A request for a preloaded file
+// skips the decode. Every publish happens on the loader thread, and the
+// kernel copy is made before the lock is taken.
+//==============================================================================
+class IRLoader : private juce::Thread, public juce::ChangeBroadcaster {
+public:
+  explicit IRLoader(std::array<IRSlot, 4> &slots);
+  ~IRLoader() override;
+
+  // Any thread: queue (or replace) the load for a slot. A decoded asset, if
+  // given, skips the decode like a preloaded one.
+  void requestLoad(int slotIndex, const juce::File &file,
+                   IRAsset::Ptr decoded = nullptr);
+
+  // Any thread: forget a pending or in-flight load for a slot
+  void cancel(int slotIndex);
+
+  // Any thread: the files a slot may load next, most likely first. They are
+  // decoded in the background and kept until no slot wants them any more.
+  void preload(int slotIndex, std::vector<juce::File> files);
+
+  IRLibraryIndex &getLibraryIndex() { return *libraryIndex; }
+
+  // Any thread: reads a file into an asset (null if unreadable)
+  IRAsset::Ptr decode(const juce::File &file);
+
+  // Longer IRs (reverbs) are not worth the memory; they load as usual
+  static constexpr double maxPreloadSeconds = 2.0;
+
+private:
+  void run() override;
+
+  struct Request {
+    juce::File file;
+    IRAsset::Ptr decoded; // Already decoded or preloaded
+    uint32_t serial = 0;  // Bumped by every request/cancel for the slot
+    bool pending = false;
+  };
+
+  // A decoded file, or a null asset for one that cannot be preloaded
+  struct Preloaded {
+    juce::File file;
+    juce::int64 modifiedMs = 0;
+    IRAsset::Ptr asset;
+  };
+
+  // All guarded by lock
+  IRAsset::Ptr findPreloaded(const juce::File &file,
+                             juce::int64 modifiedMs) const;
+  void addPreloaded(const juce::File &file, juce::int64 modifiedMs,
+                    IRAsset::Ptr asset);
+  bool isWanted(const juce::File &file) const;
+  juce::File findFileToPreload() const;
+
+  std::array<IRSlot, 4> &slots;
+  juce::CriticalSection lock;
+  std::array<Request, 4> requests;
+  int nextSlotToServe = 0;
+
+  // Bounded by the wanted lists: a file leaves as soon as no slot wants it
+  std::array<std::vector<juce::File>, 4> preloadWanted;
+  std::vector<Preloaded> preloaded;
+
+  juce::SharedResourcePointer<SharedAudioFormats> formats;
+
+  // Files the library has already measured skip the analysis
+  juce::SharedResourcePointer<IRLibraryIndex> libraryIndex;
+
+  JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(IRLoader)
+};
@@ -1,10 +1,22 @@
 #include "IRSlot.h"
+#include "AuditionEngine.h"
+#include "IRLoader.h"
+
+namespace {
+// The index's order; File::operator< ignores case on some platforms
+bool pathLess(const juce::File &a, const juce::File &b) {
+  return a.getFullPathName() < b.getFullPathName();
+}
+} // namespace
 
 IRSlot::IRSlot() {}
 
-void IRSlot::init(int index, juce::AudioProcessorValueTreeState *apvtsPtr) {
+void IRSlot::init(int index, juce::AudioProcessorValueTreeState *apvtsPtr,
+                  IRLoader *loaderPtr, AuditionEngine *auditionPtr) {
   slotID = index;
   apvts = apvtsPtr;
+  loader = loaderPtr;
+  audition = auditionPtr;
 
   // Cache parameter pointers once -- avoids String construction on audio thread
   if (apvts != nullptr) {
@@ -18,24 +30,43 @@ void IRSlot::init(int index, juce::AudioProcessorValueTreeState *apvtsPtr) {
 }
 
 void IRSlot::prepare(const juce::dsp::ProcessSpec &spec) {
+  bool rateChanged = spec.sampleRate != kernelHostRate.load();
+  kernelHostRate = spec.sampleRate;
   sampleRate = spec.sampleRate;
   blockSize = (int)spec.maximumBlockSize;
   convolution.prepare(spec);
-  delayLine.prepare(spec);
+  bakedConvolution.prepare(spec);
+
+  // Live and baked pairs share one delay line so they stay sample-aligned
+  auto delaySpec = spec;
+  delaySpec.numChannels = 4;
+  delayLine.prepare(delaySpec);
   delayLine.setMaximumDelayInSamples(4800);
   delaySmoothed.reset(sampleRate, 0.02);
 
-  slotBuffer.setSize(2, blockSize);
+  slotBuffer.setSize(4, blockSize);
+
+  // The kernel gain depends on the host rate
+  const juce::ScopedLock sl(kernelLock);
+  auto current = getAsset();
+  if (rateChanged && current != nullptr)
+    loadLiveKernel(*current);
 }
 
 void IRSlot::reset() {
   convolution.reset();
+  bakedConvolution.reset();
   delayLine.reset();
 }
 
+bool IRSlot::isLoadedOrAuditioned() const {
+  return isLoaded() || (audition != nullptr && audition->isActiveFor(slotID));
+}
+
 void IRSlot::process(const juce::AudioBuffer<float> &input,
-                     juce::AudioBuffer<float> &mixBuffer) {
-  if (!isLoaded() || delayParam == nullptr)
+                     juce::AudioBuffer<float> &mixBuffer, int engines,
+                     int fedEngines) {
+  if (!isLoadedOrAuditioned() || delayParam == nullptr)
     return;
 
   if (muteParam->load() > 0.5f)
@@ -43,19 +74,39 @@ void IRSlot::process(const juce::AudioBuffer<float> &input,
 
   int numSamples = input.getNumSamples();
   int numChannels = juce::jmin(input.getNumChannels(), 2);
+  int numOutChannels = mixBuffer.getNumChannels() >= 4 ? 4 : 2;
 
-  slotBuffer.setSize(2, numSamples, false, false, true);
+  slotBuffer.setSize(4, numSamples, false, false, true);
   slotBuffer.clear();
 
-  for (int ch = 0; ch < 2; ++ch) {
-    int srcCh = juce::jmin(ch, numChannels - 1);
-    slotBuffer.copyFrom(ch, 0, input, srcCh, 0, numSamples);
-  }
+  // 1. Convolution, per engine pair. An idle pair stays silent so its delay
+  // channels flush while it isn't needed; an unfed one rings out.
+  for (int pair = 0; pair < numOutChannels / 2; ++pair) {
+    bool baked = pair == 1;
+    int engine = baked ? bakedEngine : liveEngine;
+    if ((engines & engine) == 0)
+      continue;
+
+    // An auditioned empty slot has no baked kernel
+    if (baked && !isLoaded())
+      continue;
+
+    if ((fedEngines & engine) != 0) {
+      for (int ch = 0; ch < 2; ++ch) {
+        int srcCh = juce::jmin(ch, numChannels - 1);
+        slotBuffer.copyFrom(pair * 2 + ch, 0, input, srcCh, 0, numSamples);
+      }
+    }
 
-  // 1. Convolution
-  juce::dsp::AudioBlock<float> block(slotBuffer);
-  juce::dsp::ProcessContextReplacing<float> context(block);
-  convolution.process(context);
+    auto block = juce::dsp::AudioBlock<float>(slotBuffer)
+                     .getSubsetChannelBlock((size_t)(pair * 2), 2)
+                     .getSubBlock(0, (size_t)numSamples);
+    juce::dsp::ProcessContextReplacing<float> context(block);
+    if (!baked && audition != nullptr && audition->isActiveFor(slotID))
+      audition->process(context, convolution);
+    else
+      (baked ? bakedConvolution : convolution).process(context);
+  }
 
   // 2. Delay (User Delay + Alignment Delay)
   float userDelayMs = delayParam->load();
@@ -67,7 +118,7 @@ void IRSlot::process(const juce::AudioBuffer<float> &input,
   for (int i = 0; i < numSamples; ++i) {
     float d = delaySmoothed.getNextValue();
     delayLine.setDelay(d);
-    for (int ch = 0; ch < 2; ++ch) {
+    for (int ch = 0; ch < numOutChannels; ++ch) {
       float in = slotBuffer.getSample(ch, i);
       delayLine.pushSample(ch, in);
       slotBuffer.setSample(ch, i, delayLine.popSample(ch));
@@ -81,9 +132,9 @@ void IRSlot::process(const juce::AudioBuffer<float> &input,
   float gainL = std::cos(angle);
   float gainR = std::sin(angle);
 
-  {
-    float *dataL = slotBuffer.getWritePointer(0);
-    float *dataR = slotBuffer.getWritePointer(1);
+  for (int pair = 0; pair < numOutChannels / 2; ++pair) {
+    float *dataL = slotBuffer.getWritePointer(pair * 2);
+    float *dataR = slotBuffer.getWritePointer(pair * 2 + 1);
     for (int i = 0; i < numSamples; ++i) {
       dataL[i] *= gainL;
       dataR[i] *= gainR;
@@ -93,42 +144,150 @@ void IRSlot::process(const juce::AudioBuffer<float> &input,
   // 4. Level
   float levelDb = levelParam->load();
   float levelGain = juce::Decibels::decibelsToGain(levelDb, -60.0f);
-  slotBuffer.applyGain(levelGain);
+  slotBuffer.applyGain(0, numSamples, levelGain);
 
   // 5. Sum to mix bus
-  for (int ch = 0; ch < 2; ++ch)
+  for (int ch = 0; ch < numOutChannels; ++ch)
     mixBuffer.addFrom(ch, 0, slotBuffer, ch, 0, numSamples);
 }
 
-void IRSlot::loadImpulseResponse(const juce::File &file) {
-  if (!file.existsAsFile())
+void IRSlot::loadImpulseResponse(const juce::File &file,
+                                 IRAsset::Ptr decoded) {
+  if (!file.existsAsFile() || loader == nullptr)
     return;
 
+  const juce::ScopedLock sl(fileLock);
   currentFile = file;
-  convolution.loadImpulseResponse(file, juce::dsp::Convolution::Stereo::yes,
-                                  juce::dsp::Convolution::Trim::yes, 0);
-
-  juce::AudioFormatManager formatManager;
-  formatManager.registerBasicFormats();
-
-  std::unique_ptr<juce::AudioFormatReader> reader(
-      formatManager.createReaderFor(file));
-  if (reader) {
-    irSampleRate = reader->sampleRate;
-    irBuffer.setSize((int)reader->numChannels, (int)reader->lengthInSamples);
-    reader->read(&irBuffer, 0, (int)reader->lengthInSamples, 0, true, true);
+  loader->requestLoad(slotID, file, std::move(decoded));
+  preloadNeighbours();
+}
+
+void IRSlot::setDecodedIR(IRAsset::Ptr newAsset,
+                          juce::AudioBuffer<float> &&liveKernel,
+                          float kernelGain) {
+  // Published under the lock too, so a reload from setLoudnessMatching() or
+  // prepare() sees either the old asset or the new one with its kernel
+  const juce::ScopedLock sl(kernelLock);
+  if (newAsset != nullptr) {
+    // Loudness matching or the host rate changed while it was being built
+    float gain = getLiveKernelGain(*newAsset);
+    if (gain != kernelGain)
+      liveKernel = makeLiveKernel(*newAsset, gain);
+    installLiveKernel(std::move(liveKernel), newAsset->getSampleRate());
+  }
+  publishAsset(std::move(newAsset));
+}
+
+juce::AudioBuffer<float> IRSlot::makeLiveKernel(const IRAsset &ir,
+                                                float kernelGain) {
+  // The convolver takes ownership of its buffer, so it gets a copy of the
+  // decoded samples; the file itself is never read a second time
+  juce::AudioBuffer<float> kernel;
+  kernel.makeCopyOf(ir.getBuffer());
+  kernel.applyGain(kernelGain);
+  return kernel;
+}
+
+void IRSlot::loadLiveKernel(const IRAsset &ir) {
+  const juce::ScopedLock sl(kernelLock);
+  installLiveKernel(makeLiveKernel(ir), ir.getSampleRate());
+}
+
+void IRSlot::installLiveKernel(juce::AudioBuffer<float> &&kernel,
+                               double irRate) {
+  convolution.loadImpulseResponse(
+      std::move(kernel), irRate, juce::dsp::Convolution::Stereo::yes,
+      juce::dsp::Convolution::Trim::yes, juce::dsp::Convolution::Normalise::no);
+}
+
+float IRSlot::getKernelGain(const IRAsset &ir, double hostRate) const {
+  // Convolution::Normalise::yes would scale the loudest channel of the
+  // resampled kernel to a fixed energy; resampling scales the energy by the
+  // rate ratio, so the gain can be worked out from the stored analysis
+  const auto &analysis = ir.getAnalysis();
+  if (analysis.energyDb <= -100.0f || ir.getSampleRate() <= 0.0)
+    return 1.0f;
+
+  double energy = std::pow(10.0, analysis.energyDb / 10.0) * hostRate /
+                  ir.getSampleRate();
+  float gain = IRAnalysis::normalisedLevel / (float)std::sqrt(energy);
+  if (loudnessMatching)
+    gain *= juce::Decibels::decibelsToGain(
+        analysis.getLoudnessMatchGainDb());
+  return gain;
+}
+
+void IRSlot::setLoudnessMatching(bool shouldMatch) {
+  if (loudnessMatching.exchange(shouldMatch) == shouldMatch)
+    return;
+
+  // A new generation makes the baker rebuild its kernel with the new gain
+  const juce::ScopedLock sl(kernelLock);
+  if (auto current = getAsset()) {
+    loadLiveKernel(*current);
+    ++irGeneration;
   }
 }
 
+void IRSlot::publishAsset(IRAsset::Ptr newAsset) {
+  // The flag drops before the asset goes and rises after it arrives, so
+  // isLoaded() never promises an asset that is not there
+  bool nowLoaded = newAsset != nullptr;
+  irLengthSeconds = nowLoaded ? newAsset->getLengthSeconds() : 0.0;
+  if (!nowLoaded)
+    loaded = false;
+  std::atomic_store(&asset, IRAsset::Ptr(std::move(newAsset)));
+  loaded = nowLoaded;
+  ++irGeneration;
+}
+
+void IRSlot::resetEngines(int engines) {
+  if ((engines & liveEngine) != 0)
+    convolution.reset();
+  if ((engines & bakedEngine) != 0)
+    bakedConvolution.reset();
+}
+
+void IRSlot::loadBakedKernel(juce::AudioBuffer<float> &&kernel,
+                             double kernelRate) {
+  jassert(kernel.getNumSamples() != bakedKernelSize.load());
+  bakedKernelSize = kernel.getNumSamples();
+  bakedConvolution.loadImpulseResponse(
+      std::move(kernel), kernelRate, juce::dsp::Convolution::Stereo::yes,
+      juce::dsp::Convolution::Trim::no, juce::dsp::Convolution::Normalise::no);
+}
+
+bool IRSlot::isBakedKernelInstalled() const {
+  // Only the audio thread swaps the convolver's engine, so this is safe there
+  auto expected = bakedKernelSize.load();
+  return !isLoaded() || expected == 0 ||
+         bakedConvolution.getCurrentIRSize() == expected;
+}
+
 void IRSlot::clearImpulseResponse() {
-  currentFile = juce::File();
-  irBuffer.setSize(0, 0);
+  if (loader != nullptr) {
+    loader->cancel(slotID);
+    loader->preload(slotID, {});
+  }
+  {
+    const juce::ScopedLock sl(fileLock);
+    currentFile = juce::File();
+  }
   alignmentDelayMs = 0.0;
+  publishAsset(nullptr);
 }
 
+juce::File IRSlot::getCurrentFile() const {
+  const juce::ScopedLock sl(fileLock);
+  return currentFile;
+}
+
+bool IRSlot::isEmpty() const { return getCurrentFile() == juce::File(); }
+
 juce::String IRSlot::getSlotName() const {
-  if (currentFile.existsAsFile())
-    return currentFile.getFileNameWithoutExtension();
+  auto file = getCurrentFile();
+  if (file.existsAsFile())
+    return file.getFileNameWithoutExtension();
   return "[Empty]";
 }
 
@@ -147,52 +306,67 @@ bool IRSlot::isSoloed() const {
 void IRSlot::setAlignmentDelay(double ms) { alignmentDelayMs = ms; }
 double IRSlot::getAlignmentDelay() const { return alignmentDelayMs; }
 
-void IRSlot::loadNextIR() {
-  if (!currentFile.exists())
+void IRSlot::updateSiblings() {
+  auto folder = currentFile.getParentDirectory();
+  auto snapshot = loader->getLibraryIndex().getSnapshot();
+  if (folder == siblingFolder && snapshot == siblingSource)
     return;
 
-  auto parent = currentFile.getParentDirectory();
-  auto files =
-      parent.findChildFiles(juce::File::findFiles, false, "*.wav;*.aif;*.aiff");
-
-  if (files.isEmpty())
-    return;
-
-  int index = -1;
-  for (int i = 0; i < files.size(); ++i) {
-    if (files[i] == currentFile) {
-      index = i;
-      break;
-    }
-  }
-
-  if (index != -1) {
-    int nextIndex = (index + 1) % files.size();
-    loadImpulseResponse(files[nextIndex]);
+  siblingFolder = folder;
+  siblingSource = snapshot;
+  siblings.clear();
+
+  // Entries below the folder are sorted by path; keep its direct children
+  auto folderPath = folder.getFullPathName();
+  auto [first, last] = IRLibraryIndex::findRange(*snapshot, folder);
+  for (auto it = first; it != last; ++it)
+    if (it->path.lastIndexOf(juce::File::getSeparatorString()) ==
+        folderPath.length())
+      siblings.push_back(it->getFile());
+
+  if (siblings.empty()) {
+    auto files = folder.findChildFiles(juce::File::findFiles, false,
+                                       IRLibraryIndex::fileWildcard);
+    siblings.assign(files.begin(), files.end());
+    std::sort(siblings.begin(), siblings.end(), pathLess);
   }
 }
 
-void IRSlot::loadPrevIR() {
-  if (!currentFile.exists())
+void IRSlot::stepIR(int delta) {
+  const juce::ScopedLock sl(fileLock);
+  if (currentFile == juce::File() || loader == nullptr)
     return;
 
-  auto parent = currentFile.getParentDirectory();
-  auto files =
-      parent.findChildFiles(juce::File::findFiles, false, "*.wav;*.aif;*.aiff");
-
-  if (files.isEmpty())
+  updateSiblings();
+  if (siblings.empty())
     return;
 
-  int index = -1;
-  for (int i = 0; i < files.size(); ++i) {
-    if (files[i] == currentFile) {
-      index = i;
-      break;
-    }
-  }
+  // Binary search; a file that has gone steps from where it used to be
+  int count = (int)siblings.size();
+  int index = (int)(std::lower_bound(siblings.begin(), siblings.end(),
+                                     currentFile, pathLess) -
+                    siblings.begin());
+  bool found = index < count && siblings[(size_t)index] == currentFile;
+  if (!found && delta > 0)
+    --index;
 
-  if (index != -1) {
-    int prevIndex = (index - 1 + files.size()) % files.size();
-    loadImpulseResponse(files[prevIndex]);
+  loadImpulseResponse(siblings[(size_t)((index + delta + count) % count)]);
+}
+
+void IRSlot::preloadNeighbours() {
+  updateSiblings();
+
+  // The current file first, so stepping back to it is instant too
+  std::vector<juce::File> files{currentFile};
+  int count = (int)siblings.size();
+  auto at = std::lower_bound(siblings.begin(), siblings.end(), currentFile,
+                             pathLess);
+  if (at != siblings.end() && *at == currentFile) {
+    int index = (int)(at - siblings.begin());
+    for (int d = 1; d <= preloadDistance && 2 * d <= count; ++d) {
+      files.push_back(siblings[(size_t)((index + d) % count)]);
+      files.push_back(siblings[(size_t)((index - d + count) % count)]);
+    }
   }
+  loader->preload(slotID, std::move(files));
 }
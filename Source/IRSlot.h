@@ -1,36 +1,120 @@
 #pragma once
 
+#include "IRAsset.h"
+#include "IRLibraryIndex.h"
 #include <JuceHeader.h>
 
+class AuditionEngine;
+class IRLoader;
+
 class IRSlot {
 public:
   IRSlot();
-  void init(int slotIndex, juce::AudioProcessorValueTreeState *apvtsPtr);
+  void init(int slotIndex, juce::AudioProcessorValueTreeState *apvtsPtr,
+            IRLoader *loaderPtr, AuditionEngine *auditionPtr);
 
   void prepare(const juce::dsp::ProcessSpec &spec);
   void reset();
 
-  // Process input and ADD result into mixBuffer (stereo)
-  void process(const juce::AudioBuffer<float> &input,
-               juce::AudioBuffer<float> &mixBuffer);
+  // Which convolution engines run: the file's IR (live) and/or the kernel
+  // with the master EQ baked in. A 4-channel mix bus takes the baked pair on
+  // channels 2/3; a stereo bus only ever sees the live engine.
+  enum Engine { liveEngine = 1, bakedEngine = 2 };
 
-  void loadImpulseResponse(const juce::File &file);
+  // Process input and ADD result into mixBuffer (stereo, or 4 channels).
+  // Of the engines that run, only fedEngines hear the input; the others
+  // ring out on silence.
+  void process(const juce::AudioBuffer<float> &input,
+               juce::AudioBuffer<float> &mixBuffer, int engines = liveEngine,
+               int fedEngines = liveEngine);
+
+  // Any thread. The kernel must already be trimmed and scaled by
+  // getKernelGain(), and differ in length from getBakedKernelSize() so
+  // that its arrival can be told apart from the kernel it replaces.
+  void loadBakedKernel(juce::AudioBuffer<float> &&kernel, double kernelRate);
+  int getBakedKernelSize() const { return bakedKernelSize; }
+
+  // Audio thread: the baked engine has picked up the last kernel it was
+  // given (it does so on its next block once the kernel is built). An empty
+  // slot never runs it, so it has nothing to wait for.
+  bool isBakedKernelInstalled() const;
+
+  // Audio thread: clears the history of engines that are about to restart
+  void resetEngines(int engines);
+
+  // Any thread (the host may restore state off the message thread). The
+  // file becomes current at once; it is decoded in the background and shows
+  // up through isLoaded()/getAsset() when ready. An asset decoded elsewhere
+  // skips the decode.
+  void loadImpulseResponse(const juce::File &file,
+                           IRAsset::Ptr decoded = nullptr);
   void clearImpulseResponse();
 
-  juce::File getCurrentFile() const { return currentFile; }
+  // IRLoader thread: publish a decoded IR (null if the file was unreadable)
+  // with its makeLiveKernel() copy, built before any lock was taken at
+  // kernelGain; rebuilt if the gain has moved on since
+  void setDecodedIR(IRAsset::Ptr newAsset,
+                    juce::AudioBuffer<float> &&liveKernel, float kernelGain);
+
+  juce::File getCurrentFile() const;
   juce::String getSlotName() const;
-  bool isLoaded() const { return currentFile.existsAsFile(); }
 
-  const juce::AudioBuffer<float> &getIRBuffer() const { return irBuffer; }
-  double getIRSampleRate() const { return irSampleRate; }
+  // No file assigned (a load may still be in progress)
+  bool isEmpty() const;
+
+  // Any thread, including audio: an IR is decoded and published
+  bool isLoaded() const { return loaded; }
+
+  // Audio thread: the slot has something to play, its own IR or an
+  // audition (which may run through an empty slot)
+  bool isLoadedOrAuditioned() const;
+
+  // Any thread: snapshot of the current IR (null when empty). The asset
+  // stays valid for as long as the handle is held, whatever the slot loads
+  // in the meantime.
+  IRAsset::Ptr getAsset() const { return std::atomic_load(&asset); }
+
+  double getIRLengthSeconds() const { return irLengthSeconds; }
+
+  // Message thread: scale each IR so its K-weighted loudness lands on
+  // IRAnalysis::matchTargetDb. Reloads the current kernel when it changes.
+  void setLoudnessMatching(bool shouldMatch);
+  bool isLoudnessMatching() const { return loudnessMatching; }
+
+  // Any thread: the gain folded into a kernel built from this asset at
+  // hostRate -- the convolver's unit-energy normalisation, plus the loudness
+  // match when enabled
+  float getKernelGain(const IRAsset &ir, double hostRate) const;
+
+  // Any thread: getKernelGain() at the rate of the last prepare()
+  float getLiveKernelGain(const IRAsset &ir) const {
+    return getKernelGain(ir, kernelHostRate);
+  }
+
+  // Any thread: a copy of the IR scaled for the live engine
+  juce::AudioBuffer<float> makeLiveKernel(const IRAsset &ir) const {
+    return makeLiveKernel(ir, getLiveKernelGain(ir));
+  }
+  static juce::AudioBuffer<float> makeLiveKernel(const IRAsset &ir,
+                                                 float kernelGain);
+
+  // Bumped on every load/clear so baked kernels can tell they are stale
+  uint32_t getIRGeneration() const { return irGeneration; }
+
+  // Upper end of the DelayMs parameter; the alignment delay comes on top
+  static constexpr float maxUserDelayMs = 10.0f;
 
   void setAlignmentDelay(double delayMs);
   double getAlignmentDelay() const;
   double manualDelayMs = 0.0;
 
-  // Navigation
-  void loadNextIR();
-  void loadPrevIR();
+  // Navigation: steps through the IRs in the current file's folder. The
+  // neighbours either side are preloaded, so a step rarely waits on a decode.
+  void loadNextIR() { stepIR(1); }
+  void loadPrevIR() { stepIR(-1); }
+
+  // IRs either side of the current one kept decoded by the loader
+  static constexpr int preloadDistance = 2;
 
   bool isMuted() const;
   bool isSoloed() const;
@@ -40,11 +124,48 @@ public:
 private:
   int slotID = 0;
   juce::AudioProcessorValueTreeState *apvts = nullptr;
+  IRLoader *loader = nullptr;
+  AuditionEngine *audition = nullptr; // Stands in for the live engine
 
   juce::dsp::Convolution convolution;
-  juce::AudioBuffer<float> irBuffer;
-  double irSampleRate = 48000.0;
+  juce::dsp::Convolution bakedConvolution;
+  std::atomic<int> bakedKernelSize{0}; // Of the last kernel loaded, or 0
+  // Published with std::atomic_store; readers use getAsset()
+  IRAsset::Ptr asset;
+  std::atomic<bool> loaded{false};
+  std::atomic<double> irLengthSeconds{0.0}; // read by the host for the tail
+  std::atomic<uint32_t> irGeneration{0};
+
+  void publishAsset(IRAsset::Ptr newAsset);
+
+  // The current file and the IR files in its folder, sorted by path. The
+  // list comes from the library index and is kept until the folder or the
+  // index changes; a folder the index doesn't cover is listed from disk.
+  // Loads come from the message thread and from state restores on the
+  // host's threads, so all of it is guarded by fileLock.
+  mutable juce::CriticalSection fileLock;
   juce::File currentFile;
+  std::vector<juce::File> siblings;
+  juce::File siblingFolder;
+  IRLibraryIndex::Snapshot siblingSource;
+
+  void stepIR(int delta);
+
+  // Caller holds fileLock
+  void updateSiblings();
+  void preloadNeighbours();
+
+  // Any thread: hands the live engine a scaled copy of the IR. The
+  // convolver's load queue takes one producer at a time, and the loader,
+  // the message thread and prepare() all load kernels, so every load holds
+  // kernelLock.
+  void loadLiveKernel(const IRAsset &ir);
+  juce::CriticalSection kernelLock;
+
+  // Caller holds kernelLock
+  void installLiveKernel(juce::AudioBuffer<float> &&kernel, double irRate);
+  std::atomic<bool> loudnessMatching{false};
+  std::atomic<double> kernelHostRate{48000.0}; // Rate of the last prepare()
 
   juce::dsp::DelayLine<float,
                        juce::dsp::DelayLineInterpolationTypes::Lagrange3rd>
@@ -0,0 +1,54 @@
+#include "IRThumbnail.h"
+
+IRThumbnail IRThumbnail::create(const juce::AudioBuffer<float> &ir,
+                                int numSamplesToShow) {
+  IRThumbnail result;
+  int numSamples = juce::jlimit(0, ir.getNumSamples(), numSamplesToShow);
+  if (ir.getNumChannels() == 0 || numSamples == 0)
+    return result;
+
+  // 1. Level 0 straight from the samples, all channels folded together
+  std::array<juce::Range<float>, (size_t)numColumns> columns;
+  float peak = 0.0f;
+  for (int c = 0; c < numColumns; ++c) {
+    int start = (int)((juce::int64)c * numSamples / numColumns);
+    int end = juce::jmax(
+        start + 1, (int)((juce::int64)(c + 1) * numSamples / numColumns));
+    start = juce::jmin(start, numSamples - 1);
+    end = juce::jmin(end, numSamples);
+
+    auto range = juce::FloatVectorOperations::findMinAndMax(
+        ir.getReadPointer(0, start), end - start);
+    for (int ch = 1; ch < ir.getNumChannels(); ++ch)
+      range = range.getUnionWith(juce::FloatVectorOperations::findMinAndMax(
+          ir.getReadPointer(ch, start), end - start));
+
+    columns[(size_t)c] = range;
+    peak = juce::jmax(peak, -range.getStart(), range.getEnd());
+  }
+
+  auto quantise = [peak](float v) {
+    return (int8_t)juce::jlimit(-127, 127, juce::roundToInt(v / peak * 127.0f));
+  };
+
+  result.length = numSamples;
+  if (peak <= 0.0f)
+    return result;
+
+  for (size_t c = 0; c < columns.size(); ++c) {
+    result.peaks[c * 2] = quantise(columns[c].getStart());
+    result.peaks[c * 2 + 1] = quantise(columns[c].getEnd());
+  }
+
+  // 2. Each coarser level merges neighbouring pairs of the one below
+  for (int level = 1; level < numLevels; ++level) {
+    auto *below = result.peaks.data() + levelOffset(level - 1) * 2;
+    auto *here = result.peaks.data() + levelOffset(level) * 2;
+    for (int c = 0; c < getNumColumns(level); ++c) {
+      here[c * 2] = juce::jmin(below[c * 4], below[c * 4 + 2]);
+      here[c * 2 + 1] = juce::jmax(below[c * 4 + 1], below[c * 4 + 3]);
+    }
+  }
+
+  return result;
+}
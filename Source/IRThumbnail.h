@@ -0,0 +1,39 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// IRThumbnail: a tiny min/max peak pyramid of one impulse response, for
+// drawing a waveform in a browser row without touching the file.
+//
+// Level 0 splits the IR's audible part (up to IRAnalysis::effectiveLengthMs)
+// into numColumns min/max pairs across all channels; every further level
+// halves the column count, so any width can be drawn from the nearest level
+// without resampling. Values are 8-bit, relative to the IR's own peak.
+//==============================================================================
+struct IRThumbnail {
+  static constexpr int numColumns = 128;
+  static constexpr int numLevels = 4; // 128, 64, 32 and 16 columns
+
+  static constexpr int getNumColumns(int level) { return numColumns >> level; }
+
+  bool isEmpty() const { return length == 0; }
+
+  // Min/max pair of a column, scaled to -1..1
+  juce::Range<float> getColumn(int level, int column) const {
+    auto i = (size_t)(levelOffset(level) + column) * 2;
+    return {peaks[i] / 127.0f, peaks[i + 1] / 127.0f};
+  }
+
+  static IRThumbnail create(const juce::AudioBuffer<float> &ir,
+                            int numSamplesToShow);
+
+  static constexpr int levelOffset(int level) {
+    return level == 0 ? 0 : levelOffset(level - 1) + getNumColumns(level - 1);
+  }
+  static constexpr int totalColumns = levelOffset(numLevels);
+
+  // Samples covered by level 0, 0 for an IR without a thumbnail
+  int length = 0;
+  std::array<int8_t, (size_t)totalColumns * 2> peaks{};
+};
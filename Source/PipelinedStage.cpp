@@ -0,0 +1,167 @@
+#include "PipelinedStage.h"
+
+PipelinedStage::PipelinedStage(const juce::String &threadName)
+    : juce::Thread(threadName) {}
+
+PipelinedStage::~PipelinedStage() { release(); }
+
+void PipelinedStage::prepare(int numChannels, int maxBlockSize) {
+  release();
+
+  numStageChannels = juce::jmax(1, numChannels);
+  latencySamples = juce::jmax(1, maxBlockSize);
+
+  for (auto &b : stageBuffers)
+    b.setSize(numStageChannels, latencySamples);
+
+  // Never holds more than one latency worth plus one block
+  fifo.setSize(numStageChannels, 2 * latencySamples);
+  for (auto &m : stageMidi)
+    m.ensureSize(2048);
+
+  reset();
+
+  if (!startRealtimeThread(juce::Thread::RealtimeOptions{}.withPriority(10)))
+    startThread();
+}
+
+void PipelinedStage::release() {
+  signalThreadShouldExit();
+  wakeEvent.signal();
+  stopThread(1000);
+
+  busy = false;
+  pendingIndex = -1;
+  inFlightIndex = -1;
+}
+
+void PipelinedStage::reset() {
+  waitForWorker();
+  inFlightIndex = -1;
+
+  // Pre-fill with one latency of silence so a pop never runs dry
+  fifo.clear();
+  fifoReadPos = 0;
+  fifoWritePos = latencySamples % juce::jmax(1, fifo.getNumSamples());
+  fifoLevel = latencySamples;
+}
+
+void PipelinedStage::process(juce::AudioBuffer<float> &buffer,
+                             const juce::MidiBuffer &midi,
+                             juce::AudioPlayHead *hostPlayHead) {
+  int numSamples = buffer.getNumSamples();
+  if (numSamples <= 0 || latencySamples <= 0 || !isThreadRunning())
+    return;
+
+  // Hosts shouldn't exceed the prepared size, but if one does, keep the
+  // delay exact by feeding the stage in latency-sized chunks
+  jassert(numSamples <= latencySamples);
+
+  for (int pos = 0; pos < numSamples; pos += latencySamples) {
+    int n = juce::jmin(latencySamples, numSamples - pos);
+    juce::AudioBuffer<float> chunk(buffer.getArrayOfWritePointers(),
+                                   buffer.getNumChannels(), pos, n);
+    processChunk(chunk, midi, pos, hostPlayHead);
+  }
+}
+
+void PipelinedStage::processChunk(juce::AudioBuffer<float> &chunk,
+                                  const juce::MidiBuffer &midi, int midiStart,
+                                  juce::AudioPlayHead *hostPlayHead) {
+  int numSamples = chunk.getNumSamples();
+  int numChannels = chunk.getNumChannels();
+  if (numChannels == 0)
+    return;
+
+  // 1. Collect the previous block (normally long finished by now)
+  waitForWorker();
+  if (inFlightIndex >= 0)
+    pushToFifo(stageBuffers[(size_t)inFlightIndex],
+               stageBuffers[(size_t)inFlightIndex].getNumSamples());
+
+  // 2. Hand this block to the worker via the other buffer
+  int nextIndex = inFlightIndex == 0 ? 1 : 0;
+  auto &stage = stageBuffers[(size_t)nextIndex];
+  stage.setSize(numStageChannels, numSamples, false, false, true);
+  for (int ch = 0; ch < numStageChannels; ++ch)
+    stage.copyFrom(ch, 0, chunk, juce::jmin(ch, numChannels - 1), 0,
+                   numSamples);
+
+  // The chunk's events, moved to the start of the stage block
+  auto &stageEvents = stageMidi[(size_t)nextIndex];
+  stageEvents.clear();
+  stageEvents.addEvents(midi, midiStart, numSamples, -midiStart);
+
+  stagePlayHead.position = {};
+  if (hostPlayHead != nullptr)
+    stagePlayHead.position = hostPlayHead->getPosition();
+
+  busy.store(true, std::memory_order_relaxed);
+  pendingIndex.store(nextIndex, std::memory_order_release);
+  wakeEvent.signal();
+  inFlightIndex = nextIndex;
+
+  // 3. Output the stage result from one latency ago
+  popFromFifo(chunk, numSamples);
+}
+
+void PipelinedStage::waitForWorker() {
+  if (!busy.load(std::memory_order_acquire))
+    return;
+
+  numWaits.fetch_add(1, std::memory_order_relaxed);
+  while (busy.load(std::memory_order_acquire))
+    juce::Thread::yield();
+}
+
+void PipelinedStage::pushToFifo(const juce::AudioBuffer<float> &source,
+                                int numSamples) {
+  int capacity = fifo.getNumSamples();
+  jassert(fifoLevel + numSamples <= capacity);
+
+  int first = juce::jmin(numSamples, capacity - fifoWritePos);
+  for (int ch = 0; ch < numStageChannels; ++ch) {
+    fifo.copyFrom(ch, fifoWritePos, source, ch, 0, first);
+    if (numSamples > first)
+      fifo.copyFrom(ch, 0, source, ch, first, numSamples - first);
+  }
+
+  fifoWritePos = (fifoWritePos + numSamples) % capacity;
+  fifoLevel += numSamples;
+}
+
+void PipelinedStage::popFromFifo(juce::AudioBuffer<float> &dest,
+                                 int numSamples) {
+  int capacity = fifo.getNumSamples();
+  jassert(fifoLevel >= numSamples);
+
+  int first = juce::jmin(numSamples, capacity - fifoReadPos);
+  for (int ch = 0; ch < dest.getNumChannels(); ++ch) {
+    int srcCh = juce::jmin(ch, numStageChannels - 1);
+    dest.copyFrom(ch, 0, fifo, srcCh, fifoReadPos, first);
+    if (numSamples > first)
+      dest.copyFrom(ch, first, fifo, srcCh, 0, numSamples - first);
+  }
+
+  fifoReadPos = (fifoReadPos + numSamples) % capacity;
+  fifoLevel -= numSamples;
+}
+
+void PipelinedStage::run() {
+  // Denormal flags are per-thread, so set them here as processBlock does
+  juce::ScopedNoDenormals noDenormals;
+
+  while (!threadShouldExit()) {
+    wakeEvent.wait(100);
+
+    int index = pendingIndex.exchange(-1, std::memory_order_acquire);
+    if (index < 0)
+      continue;
+
+    if (processCallback)
+      processCallback(stageBuffers[(size_t)index], stageMidi[(size_t)index],
+                      &stagePlayHead);
+
+    busy.store(false, std::memory_order_release);
+  }
+}
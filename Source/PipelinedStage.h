@@ -0,0 +1,83 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// PipelinedStage: runs one processing stage on its own realtime thread, one
+// block behind the audio thread. Each call hands the current block to the
+// worker and returns the stage output delayed by exactly getLatencySamples(),
+// so the caller's remaining chain overlaps with the stage instead of waiting
+// for it. Audio and MIDI are double-buffered; the handoff is lock-free. The
+// stage hears its MIDI one latency late, in step with its audio.
+//==============================================================================
+class PipelinedStage : private juce::Thread {
+public:
+  using ProcessFn = std::function<void(
+      juce::AudioBuffer<float> &, juce::MidiBuffer &, juce::AudioPlayHead *)>;
+
+  explicit PipelinedStage(const juce::String &threadName);
+  ~PipelinedStage() override;
+
+  // Set once before prepare(); called on the worker thread for every block
+  void setProcessCallback(ProcessFn fn) { processCallback = std::move(fn); }
+
+  // Allocates the buffers and starts the worker. Call from prepareToPlay.
+  void prepare(int numChannels, int maxBlockSize);
+  void release();
+
+  // Audio thread: feeds `buffer` and its MIDI to the stage and replaces the
+  // buffer's contents with stage output from getLatencySamples() samples
+  // ago. `midi` is left as it is.
+  void process(juce::AudioBuffer<float> &buffer, const juce::MidiBuffer &midi,
+               juce::AudioPlayHead *hostPlayHead);
+
+  // Audio thread: waits for any in-flight block and flushes the delay line
+  void reset();
+
+  int getLatencySamples() const { return latencySamples; }
+
+  // Number of blocks where the audio thread had to wait for the worker
+  uint32_t getNumWaits() const { return numWaits.load(); }
+
+private:
+  void run() override;
+
+  void processChunk(juce::AudioBuffer<float> &chunk,
+                    const juce::MidiBuffer &midi, int midiStart,
+                    juce::AudioPlayHead *hostPlayHead);
+  void waitForWorker();
+  void pushToFifo(const juce::AudioBuffer<float> &source, int numSamples);
+  void popFromFifo(juce::AudioBuffer<float> &dest, int numSamples);
+
+  // The hosted stage runs outside the host callback, so it gets a copy of
+  // the transport state taken when its block was handed over
+  struct SnapshotPlayHead : public juce::AudioPlayHead {
+    juce::Optional<PositionInfo> getPosition() const override {
+      return position;
+    }
+    juce::Optional<PositionInfo> position;
+  };
+
+  ProcessFn processCallback;
+
+  std::array<juce::AudioBuffer<float>, 2> stageBuffers;
+  std::array<juce::MidiBuffer, 2> stageMidi;
+  SnapshotPlayHead stagePlayHead;
+  int inFlightIndex = -1; // audio thread only
+
+  // Delay FIFO holding finished stage output (audio thread only)
+  juce::AudioBuffer<float> fifo;
+  int fifoReadPos = 0;
+  int fifoWritePos = 0;
+  int fifoLevel = 0;
+
+  int numStageChannels = 2;
+  int latencySamples = 0;
+
+  juce::WaitableEvent wakeEvent;
+  std::atomic<int> pendingIndex{-1};
+  std::atomic<bool> busy{false};
+  std::atomic<uint32_t> numWaits{0};
+
+  JUCE_DECLARE_NON_COPYABLE(PipelinedStage)
+};
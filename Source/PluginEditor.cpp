@@ -14,9 +14,9 @@ FreeIREditor::FreeIREditor(FreeIRAudioProcessor &p)
 
   // Browser
   browser.onLoadIR = [this](juce::File f) {
-    if (proc.getIRSlot(0).isLoaded()) {
+    if (!proc.getIRSlot(0).isEmpty()) {
       for (int i = 0; i < 4; ++i) {
-        if (!proc.getIRSlot(i).isLoaded()) {
+        if (proc.getIRSlot(i).isEmpty()) {
           proc.getIRSlot(i).loadImpulseResponse(f);
           return;
         }
@@ -77,6 +77,72 @@ FreeIREditor::FreeIREditor(FreeIRAudioProcessor &p)
 
     m.addSubMenu("Export Sample Rate", srMenu);
 
+    m.addSectionHeader("Loading");
+    m.addItem("Match IR Loudness", true, proc.isLoudnessMatching(),
+              [this] { proc.setLoudnessMatching(!proc.isLoudnessMatching()); });
+
+    m.addSectionHeader("Auto Align");
+    auto alignSettings = proc.getAutoAligner().getSettings();
+    auto changeAlignment = [this](auto change) {
+      auto &a = proc.getAutoAligner();
+      auto s = a.getSettings();
+      change(s);
+      a.setSettings(s);
+      if (isAutoAlignOn)
+        a.performAlignment();
+    };
+
+    using Objective = AutoAligner::Objective;
+    m.addItem("Align for Band Coherence", true,
+              alignSettings.objective == Objective::bandCoherence,
+              [changeAlignment] {
+                changeAlignment([](AutoAligner::Settings &s) {
+                  s.objective = Objective::bandCoherence;
+                });
+              });
+    m.addItem("Align for Peak Correlation", true,
+              alignSettings.objective == Objective::peakCorrelation,
+              [changeAlignment] {
+                changeAlignment([](AutoAligner::Settings &s) {
+                  s.objective = Objective::peakCorrelation;
+                });
+              });
+    m.addItem("Whitened Correlation (PHAT)",
+              alignSettings.objective == Objective::peakCorrelation,
+              alignSettings.phatWeighting, [changeAlignment] {
+                changeAlignment([](AutoAligner::Settings &s) {
+                  s.phatWeighting = !s.phatWeighting;
+                });
+              });
+
+    juce::PopupMenu rangeMenu;
+    for (double ms : {5.0, 10.0, 20.0, 50.0})
+      rangeMenu.addItem(juce::String((int)ms) + " ms", true,
+                        alignSettings.searchRangeMs == ms,
+                        [changeAlignment, ms] {
+                          changeAlignment([ms](AutoAligner::Settings &s) {
+                            s.searchRangeMs = ms;
+                          });
+                        });
+    m.addSubMenu("Search Range", rangeMenu);
+
+    m.addSectionHeader("Performance");
+    m.addItem("Parallel Slot Processing", true,
+              proc.isParallelSlotProcessing(), [this] {
+                proc.setParallelSlotProcessing(
+                    !proc.isParallelSlotProcessing());
+              });
+    m.addItem("Pipelined Plugin Processing (+1 block latency)", true,
+              proc.isPipelinedHostedProcessing(), [this] {
+                proc.setPipelinedHostedProcessing(
+                    !proc.isPipelinedHostedProcessing());
+              });
+    m.addItem("Bake Static EQ into IRs", true, proc.isBakedEQ(),
+              [this] { proc.setBakedEQ(!proc.isBakedEQ()); });
+    m.addItem("Audio Thread Waits: " +
+                  juce::String(proc.getNumAudioThreadWaits()),
+              false, false, nullptr);
+
     m.showMenuAsync(
         juce::PopupMenu::Options().withTargetComponent(settingsButton));
   };
@@ -111,6 +177,9 @@ FreeIREditor::FreeIREditor(FreeIRAudioProcessor &p)
       proc.getAutoAligner().performAlignment();
     } else {
       proc.revertAutoAlignment();
+      for (auto &slot : slotComponents)
+        if (slot)
+          slot->showAlignmentResult(-1.0, false);
       refreshWaveform();
     }
   };
@@ -156,6 +225,7 @@ FreeIREditor::FreeIREditor(FreeIRAudioProcessor &p)
 
   // Register for auto-align callbacks & init
   proc.getAutoAligner().addListener(this);
+  proc.getIRLoader().addChangeListener(this);
 
   startTimerHz(15);
   refreshWaveform();
@@ -164,7 +234,9 @@ FreeIREditor::FreeIREditor(FreeIRAudioProcessor &p)
 
 FreeIREditor::~FreeIREditor() {
   hostedPluginWindow.reset();
+  chainWindows.clear();
   proc.getAutoAligner().removeListener(this);
+  proc.getIRLoader().removeChangeListener(this);
   setLookAndFeel(nullptr);
 }
 
@@ -309,7 +381,20 @@ void FreeIREditor::timerCallback() { updatePluginButtonText(); }
 
 void FreeIREditor::alignmentComplete() {
   proc.applyAlignmentResults();
+
+  const auto &aligner = proc.getAutoAligner();
+  for (size_t i = 0; i < slotComponents.size(); ++i)
+    if (slotComponents[i])
+      slotComponents[i]->showAlignmentResult(aligner.getConfidence((int)i),
+                                             aligner.outOfRange[i]);
+  refreshWaveform();
+}
+
+void FreeIREditor::changeListenerCallback(juce::ChangeBroadcaster *) {
   refreshWaveform();
+  for (auto &s : slotComponents)
+    if (s)
+      s->updateSlotDisplay();
 }
 
 //==============================================================================
@@ -323,9 +408,8 @@ void FreeIREditor::refreshWaveform() {
       currentDelayMs = *proc.getAPVTS().getRawParameterValue(
           "Slot" + juce::String(i + 1) + "_DelayMs");
 
-    if (slot.isLoaded())
-      waveformDisplay.setIRData(i, &slot.getIRBuffer(), slot.getIRSampleRate(),
-                                (double)currentDelayMs);
+    if (auto asset = slot.getAsset())
+      waveformDisplay.setIRData(i, std::move(asset), (double)currentDelayMs);
     else
       waveformDisplay.clearSlot(i);
   }
@@ -378,14 +462,18 @@ void FreeIREditor::showPluginMenu() {
         "All Plugins (" +
             juce::String(proc.getKnownPluginList().getNumTypes()) + ")",
         fullList);
+
+    menu.addSeparator();
+    addPluginChainMenu(menu);
   }
 
   menu.showMenuAsync(
       juce::PopupMenu::Options().withTargetComponent(pluginButton));
 }
 
-juce::PopupMenu
-FreeIREditor::buildPluginListMenu(const juce::String &filter) {
+juce::PopupMenu FreeIREditor::buildPluginListMenu(
+    const juce::String &filter,
+    std::function<void(const juce::PluginDescription &)> onChosen) {
   juce::PopupMenu result;
 
   auto &knownList = proc.getKnownPluginList();
@@ -427,7 +515,14 @@ FreeIREditor::buildPluginListMenu(const juce::String &filter) {
       tag = " [AU]";
 
     byManufacturer[desc.manufacturerName].addItem(
-        desc.name + tag, [this, desc]() {
+        desc.name + tag, [this, desc, onChosen]() {
+          if (onChosen) {
+            onChosen(desc);
+            return;
+          }
+
+          // The current instance is retired on load; close its editor first
+          hostedPluginWindow.reset();
           proc.loadHostedPlugin(desc, [this](bool success) {
             juce::MessageManager::callAsync([this, success]() {
               if (success) {
@@ -547,6 +642,109 @@ void FreeIREditor::clearHostedPlugin() {
   updatePluginButtonText();
 }
 
+//==============================================================================
+// Plugin Chain
+//==============================================================================
+void FreeIREditor::addPluginChainMenu(juce::PopupMenu &menu) {
+  using Stage = HostedPluginGraph::Stage;
+  auto &graph = proc.getHostedGraph();
+
+  menu.addSectionHeader("Plugin Chain");
+
+  // Existing nodes (the primary one is handled above)
+  for (auto &node : graph.getNodes()) {
+    if (node.id == graph.getPrimaryNode())
+      continue;
+
+    juce::String label = "Branch " + juce::String(node.branch + 1);
+    if (node.stage == Stage::pre)
+      label = "Pre";
+    else if (node.stage == Stage::post)
+      label = "Post";
+    label << ": " << (node.name.isNotEmpty() ? node.name : "(empty)");
+
+    juce::PopupMenu nodeMenu;
+    int id = node.id;
+    nodeMenu.addItem("Show Editor", [this, id]() { showChainNodeEditor(id); });
+    nodeMenu.addItem("Bypass", true, node.bypassed,
+                     [this, id, bypassed = node.bypassed]() {
+                       proc.getHostedGraph().setNodeBypassed(id, !bypassed);
+                     });
+    nodeMenu.addItem("Remove", [this, id]() { removeChainNode(id); });
+    menu.addSubMenu(label, nodeMenu);
+  }
+
+  menu.addSubMenu("Add Pre-IR Plugin",
+                  buildPluginListMenu("", [this](auto &desc) {
+                    addChainPlugin(Stage::pre, 0, desc);
+                  }));
+  menu.addSubMenu("Add Post-IR Plugin",
+                  buildPluginListMenu("", [this](auto &desc) {
+                    addChainPlugin(Stage::post, 0, desc);
+                  }));
+
+  juce::PopupMenu branchMenu;
+  for (int b = 0; b < HostedPluginGraph::maxBranches; ++b)
+    branchMenu.addSubMenu("Branch " + juce::String(b + 1),
+                          buildPluginListMenu("", [this, b](auto &desc) {
+                            addChainPlugin(Stage::branch, b, desc);
+                          }));
+  menu.addSubMenu("Add Branch Plugin", branchMenu);
+
+  // Which branch each IR slot listens to
+  juce::PopupMenu routingMenu;
+  for (int s = 0; s < HostedPluginGraph::numSlots; ++s) {
+    juce::PopupMenu slotMenu;
+    int current = graph.getSlotInput(s);
+    slotMenu.addItem("Main", true, current == HostedPluginGraph::mainInput,
+                     [this, s]() {
+                       proc.getHostedGraph().setSlotInput(
+                           s, HostedPluginGraph::mainInput);
+                     });
+    for (int b = 0; b < HostedPluginGraph::maxBranches; ++b)
+      slotMenu.addItem("Branch " + juce::String(b + 1), true, current == b,
+                       [this, s, b]() {
+                         proc.getHostedGraph().setSlotInput(s, b);
+                       });
+    routingMenu.addSubMenu("Slot " + juce::String(s + 1), slotMenu);
+  }
+  menu.addSubMenu("Slot Inputs", routingMenu);
+}
+
+void FreeIREditor::addChainPlugin(HostedPluginGraph::Stage stage, int branch,
+                                  const juce::PluginDescription &desc) {
+  int nodeId = proc.getHostedGraph().addNode(stage, branch);
+  proc.loadHostedPluginIntoNode(nodeId, desc, [this, nodeId](bool success) {
+    juce::MessageManager::callAsync([this, nodeId, success]() {
+      if (success)
+        showChainNodeEditor(nodeId);
+      else
+        proc.getHostedGraph().removeNode(nodeId);
+    });
+  });
+}
+
+void FreeIREditor::showChainNodeEditor(int nodeId) {
+  auto *plugin = proc.getHostedGraph().getNodeInstance(nodeId);
+  if (plugin == nullptr)
+    return;
+
+  auto &window = chainWindows[nodeId];
+  if (window != nullptr) {
+    window->setVisible(true);
+    window->toFront(true);
+    return;
+  }
+
+  if (auto *editor = plugin->createEditorIfNeeded())
+    window = std::make_unique<HostedPluginWindow>(editor, plugin->getName());
+}
+
+void FreeIREditor::removeChainNode(int nodeId) {
+  chainWindows.erase(nodeId);
+  proc.getHostedGraph().removeNode(nodeId);
+}
+
 void FreeIREditor::updatePluginButtonText() {
   if (proc.hasHostedPlugin()) {
     auto name = proc.getHostedPluginName();
@@ -35,6 +35,7 @@ private:
 //==============================================================================
 class FreeIREditor : public juce::AudioProcessorEditor,
                      public juce::Timer,
+                     public juce::ChangeListener,
                      public AutoAligner::Listener {
 public:
   explicit FreeIREditor(FreeIRAudioProcessor &processor);
@@ -46,6 +47,9 @@ public:
   void timerCallback() override;
   void alignmentComplete() override;
 
+  // IR loads finish in the background
+  void changeListenerCallback(juce::ChangeBroadcaster *source) override;
+
 private:
   FreeIRAudioProcessor &proc;
   FreeIRLookAndFeel lnf;
@@ -89,6 +93,7 @@ private:
   // Plugin hosting
   juce::TextButton pluginButton{"Load Plugin"};
   std::unique_ptr<HostedPluginWindow> hostedPluginWindow;
+  std::map<int, std::unique_ptr<HostedPluginWindow>> chainWindows;
   bool pluginScanComplete = false;
   bool pluginScanInProgress = false;
 
@@ -126,7 +131,16 @@ private:
   void clearHostedPlugin();
   void updatePluginButtonText();
   void showFilteredPluginMenu(const juce::String &filter);
-  juce::PopupMenu buildPluginListMenu(const juce::String &filter);
+  juce::PopupMenu buildPluginListMenu(
+      const juce::String &filter,
+      std::function<void(const juce::PluginDescription &)> onChosen = nullptr);
+
+  // Plugin chain (pre/post chains and parallel branches)
+  void addPluginChainMenu(juce::PopupMenu &menu);
+  void addChainPlugin(HostedPluginGraph::Stage stage, int branch,
+                      const juce::PluginDescription &desc);
+  void showChainNodeEditor(int nodeId);
+  void removeChainNode(int nodeId);
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FreeIREditor)
 };
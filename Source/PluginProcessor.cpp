@@ -12,15 +12,38 @@ FreeIRAudioProcessor::FreeIRAudioProcessor()
       apvts(*this, nullptr, "PARAMETERS", createParameterLayout()),
       eqProcessor(apvts), autoAligner(slots) {
   for (int i = 0; i < numSlots; ++i)
-    slots[i].init(i, &apvts);
+    slots[i].init(i, &apvts, &irLoader, &audition);
+
+  autoAligner.setCacheFile(
+      presetManager.getRootFolder().getChildFile("AlignmentCache.bin"));
 
   // Register plugin formats for hosted amp sim support
   juce::addDefaultFormatsToManager(pluginFormatManager);
+
+  dryMixParam = apvts.getRawParameterValue("DryMix");
+  for (int i = 0; i < numSlots; ++i) {
+    auto prefix = "Slot" + juce::String(i + 1) + "_";
+    auto &params = slotToneParams[(size_t)i];
+    params.loCut = apvts.getRawParameterValue(prefix + "LoCutHz");
+    params.hiCut = apvts.getRawParameterValue(prefix + "HiCutHz");
+    params.tilt = apvts.getRawParameterValue(prefix + "TiltDb");
+  }
+  hostedGraph.onLatencyChanged = [this] { updateLatency(); };
+
+  // Only the pre chain is pipelined; branches and post run on the audio
+  // thread as usual
+  hostedPipeline.setProcessCallback(
+      [this](juce::AudioBuffer<float> &buffer, juce::MidiBuffer &midi,
+             juce::AudioPlayHead *playHead) {
+        hostedGraph.processPre(buffer, midi, playHead,
+                               HostedPluginGraph::pipelineThread);
+      });
 }
 
 FreeIRAudioProcessor::~FreeIRAudioProcessor() {
-  const juce::ScopedLock sl(hostedPluginLock);
-  hostedPlugin.reset();
+  // Worker threads call into the hosted plugin, so stop them first
+  hostedPipeline.release();
+  slotWorkers.stop();
 }
 
 //==============================================================================
@@ -47,7 +70,25 @@ FreeIRAudioProcessor::createParameterLayout() {
 
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID(prefix + "DelayMs", 1), prefix + "Delay",
-        juce::NormalisableRange<float>(0.0f, 10.0f, 0.01f), 0.0f));
+        juce::NormalisableRange<float>(0.0f, IRSlot::maxUserDelayMs, 0.001f),
+        0.0f));
+
+    // Per-slot tone; the range ends switch the filters off
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID(prefix + "LoCutHz", 1), prefix + "Lo Cut",
+        juce::NormalisableRange<float>(SlotToneBank::minLoCutHz, 500.0f, 1.0f,
+                                       0.5f),
+        SlotToneBank::minLoCutHz));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID(prefix + "HiCutHz", 1), prefix + "Hi Cut",
+        juce::NormalisableRange<float>(2000.0f, SlotToneBank::maxHiCutHz, 1.0f,
+                                       0.5f),
+        SlotToneBank::maxHiCutHz));
+
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID(prefix + "TiltDb", 1), prefix + "Tilt",
+        juce::NormalisableRange<float>(-6.0f, 6.0f, 0.1f), 0.0f));
   }
 
   // EQ Parameters
@@ -87,6 +128,10 @@ FreeIRAudioProcessor::createParameterLayout() {
       juce::ParameterID("OutputGainDb", 1), "Output",
       juce::NormalisableRange<float>(-24.0f, 6.0f, 0.1f), 0.0f));
 
+  layout.add(std::make_unique<juce::AudioParameterFloat>(
+      juce::ParameterID("DryMix", 1), "Dry Mix",
+      juce::NormalisableRange<float>(0.0f, 100.0f, 0.1f), 0.0f));
+
   return layout;
 }
 
@@ -103,27 +148,51 @@ void FreeIRAudioProcessor::prepareToPlay(double sampleRate,
 
   for (auto &slot : slots)
     slot.prepare(spec);
+  audition.prepare(spec);
 
   eqProcessor.prepare(spec);
-
-  mixBuffer.setSize(2, samplesPerBlock);
-
-  // Prepare hosted plugin if loaded
-  {
-    const juce::ScopedLock sl(hostedPluginLock);
-    if (hostedPlugin != nullptr)
-      hostedPlugin->prepareToPlay(sampleRate, samplesPerBlock);
-  }
+  for (auto &bank : slotTone)
+    bank.prepare(sampleRate, samplesPerBlock);
+
+  mixBuffer.setSize(4, samplesPerBlock);
+  for (auto &out : slotOutputs)
+    out.setSize(4, samplesPerBlock);
+
+  kernelBaker.prepare(sampleRate, samplesPerBlock);
+  fedEngine = IRSlot::liveEngine;
+  runningEngines = IRSlot::liveEngine;
+  liveRingOutSamples = bakedRingOutSamples = 0;
+  bakedSwapFadeSamples = (int)(convolverFadeSeconds * sampleRate);
+  bakedSwapWaitSamples = 0;
+
+  // One worker fewer than slots: the audio thread takes a slot itself
+  slotWorkers.start(
+      juce::jmax(0, juce::jmin(numSlots - 1,
+                               juce::SystemStats::getNumCpus() - 1)));
+
+  hostedPipeline.prepare(2, samplesPerBlock);
+  pipelineActive = false;
+
+  // Room for a second of hosted-plugin latency plus a pipelined block
+  dryDelay.prepare(spec);
+  dryDelay.setMaximumDelayInSamples((int)sampleRate + samplesPerBlock);
+  dryBuffer.setSize(2, samplesPerBlock);
+  dryMix.reset(sampleRate, 0.05);
+  dryPathRunning = false;
+
+  updateLatency();
+
+  // Prepare hosted plugins
+  hostedGraph.prepare(sampleRate, samplesPerBlock);
 }
 
 void FreeIRAudioProcessor::releaseResources() {
   for (auto &slot : slots)
     slot.reset();
   eqProcessor.reset();
-
-  const juce::ScopedLock sl(hostedPluginLock);
-  if (hostedPlugin != nullptr)
-    hostedPlugin->releaseResources();
+  slotWorkers.stop();
+  hostedPipeline.release();
+  hostedGraph.releaseResources();
 }
 
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -151,45 +220,103 @@ void FreeIRAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
   for (int i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
     buffer.clear(i, 0, numSamples);
 
-  // Route through hosted amp sim plugin (pre-IR chain)
-  {
-    const juce::ScopedLock sl(hostedPluginLock);
-    if (hostedPlugin != nullptr)
-      hostedPlugin->processBlock(buffer, midiMessages);
+  // Keep the input for the latency-compensated dry path
+  float dryTarget = dryMixParam->load() * 0.01f;
+  dryMix.setTargetValue(dryTarget);
+  bool dryActive = dryTarget > 0.0f || dryMix.isSmoothing();
+  if (dryActive) {
+    if (!dryPathRunning)
+      dryDelay.reset();
+    dryBuffer.setSize(2, numSamples, false, false, true);
+    for (int ch = 0; ch < 2; ++ch)
+      dryBuffer.copyFrom(ch, 0, buffer,
+                         juce::jmin(ch, totalNumInputChannels - 1), 0,
+                         numSamples);
   }
+  dryPathRunning = dryActive;
+
+  // Route through the hosted pre-IR chain (pedal -> amp). In pipelined mode
+  // the chain works on this block while we run the IR bank on the last one.
+  bool pipelined = pipelinedHostedProcessing;
+  if (pipelined != pipelineActive) {
+    hostedPipeline.reset();
+    pipelineActive = pipelined;
+  }
+
+  if (pipelined)
+    hostedPipeline.process(buffer, midiMessages, getPlayHead());
+  else
+    hostedGraph.processPre(buffer, midiMessages, getPlayHead(),
+                           HostedPluginGraph::audioThread);
+
+  // Before anything asks a slot whether it is auditioned
+  audition.update(numSamples);
 
   // Check if any slot is soloed
   bool anySoloed = false;
   for (size_t i = 0; i < (size_t)numSlots; ++i) {
-    if (slots[i].isLoaded() && slots[i].isSoloed()) {
+    if (slots[i].isLoadedOrAuditioned() && slots[i].isSoloed()) {
       anySoloed = true;
       break;
     }
   }
 
-  // Clear mix bus
-  mixBuffer.setSize(2, numSamples, false, false, true);
+  // Clear mix bus; the second pair only exists while the baked engines run
+  int engines = selectSlotEngines(numSamples);
+  int numMixChannels = (engines & IRSlot::bakedEngine) != 0 ? 4 : 2;
+  mixBuffer.setSize(numMixChannels, numSamples, false, false, true);
   mixBuffer.clear();
 
-  // Process each slot
-  for (size_t i = 0; i < (size_t)numSlots; ++i) {
-    if (!slots[i].isLoaded())
+  // Collect the slots that contribute this block
+  std::array<int, numSlots> activeSlots{};
+  int numActive = 0;
+  for (int i = 0; i < numSlots; ++i) {
+    const auto &slot = slots[(size_t)i];
+    if (!slot.isLoadedOrAuditioned() || slot.isMuted())
       continue;
 
     // Solo logic: if any slot is soloed, skip non-soloed slots
-    if (anySoloed && !slots[i].isSoloed())
+    if (anySoloed && !slot.isSoloed())
       continue;
 
-    slots[i].process(buffer, mixBuffer);
+    activeSlots[(size_t)numActive++] = i;
   }
 
-  // Copy mix result back to main buffer (ensure stereo)
+  // Parallel branches (e.g. two amps) feed the slots routed to them
+  std::array<const juce::AudioBuffer<float> *, numSlots> slotInputs{};
+  hostedGraph.processBranches(buffer, getPlayHead(), slotWorkers, slotInputs);
+
+  processSlots(slotInputs, activeSlots, numActive, numSamples, engines);
+  updateBakedSwap(activeSlots, numActive, numSamples);
+
+  // EQ the live pair while it runs, then sum the pairs into the main
+  // buffer: each holds the response to its own stretch of the input
+  if ((engines & IRSlot::liveEngine) != 0)
+    eqProcessor.process(mixBuffer);
+
   buffer.setSize(2, numSamples, true, false, true);
-  for (int ch = 0; ch < 2; ++ch)
+  for (int ch = 0; ch < 2; ++ch) {
     buffer.copyFrom(ch, 0, mixBuffer, ch, 0, numSamples);
+    if (numMixChannels == 4)
+      buffer.addFrom(ch, 0, mixBuffer, ch + 2, 0, numSamples);
+  }
 
-  // Apply EQ chain
-  eqProcessor.process(buffer);
+  // Post-IR hosted chain
+  hostedGraph.processPost(buffer, midiMessages, getPlayHead());
+
+  // Blend in the dry input, delayed to line up with the wet path
+  if (dryActive) {
+    dryDelay.setDelay((float)internalLatencySamples.load());
+    for (int i = 0; i < numSamples; ++i) {
+      float mix = dryMix.getNextValue();
+      for (int ch = 0; ch < 2; ++ch) {
+        dryDelay.pushSample(ch, dryBuffer.getSample(ch, i));
+        float dry = dryDelay.popSample(ch);
+        buffer.setSample(ch, i,
+                         buffer.getSample(ch, i) * (1.0f - mix) + dry * mix);
+      }
+    }
+  }
 
   // Apply output gain
   float outGainDb = apvts.getRawParameterValue("OutputGainDb")->load();
@@ -197,34 +324,235 @@ void FreeIRAudioProcessor::processBlock(juce::AudioBuffer<float> &buffer,
   buffer.applyGain(outGain);
 }
 
+int FreeIRAudioProcessor::selectSlotEngines(int numSamples) {
+  // An audition plays through the live engine, where the EQ runs live
+  bool wantBaked = kernelBaker.isBakedCurrent() && !audition.isActive();
+  int wanted = wantBaked ? IRSlot::bakedEngine : IRSlot::liveEngine;
+
+  // Handover: the pair the input leaves rings out on silence
+  if (wanted != fedEngine) {
+    int tail = (int)(getIRTailSeconds() * currentSampleRate);
+    if (fedEngine == IRSlot::liveEngine)
+      liveRingOutSamples = tail;
+    else
+      bakedRingOutSamples = tail;
+    fedEngine = wanted;
+  }
+
+  int engines = fedEngine;
+  if (liveRingOutSamples > 0) {
+    engines |= IRSlot::liveEngine;
+    liveRingOutSamples -= numSamples;
+  }
+  if (bakedRingOutSamples > 0) {
+    engines |= IRSlot::bakedEngine;
+    bakedRingOutSamples -= numSamples;
+  }
+
+  // A convolver only picks up a new kernel while it runs
+  if (kernelBaker.isEnabled() && kernelBaker.isSwapPending())
+    engines |= IRSlot::bakedEngine;
+
+  // A pair coming back from rest starts from a clean history, and so do
+  // the filters that follow it
+  int starting = engines & ~runningEngines;
+  if (starting != 0) {
+    for (auto &slot : slots)
+      slot.resetEngines(starting);
+    if ((starting & IRSlot::liveEngine) != 0) {
+      slotTone[0].reset();
+      eqProcessor.reset();
+    }
+    if ((starting & IRSlot::bakedEngine) != 0)
+      slotTone[1].reset();
+  }
+  runningEngines = engines;
+  return engines;
+}
+
+void FreeIRAudioProcessor::updateBakedSwap(
+    const std::array<int, numSlots> &activeSlots, int numActive,
+    int numSamples) {
+  int fadeSamples = (int)(convolverFadeSeconds * currentSampleRate);
+  if (!kernelBaker.isSwapPending() ||
+      (runningEngines & IRSlot::bakedEngine) == 0) {
+    bakedSwapFadeSamples = fadeSamples;
+    bakedSwapWaitSamples = 0;
+    return;
+  }
+
+  // Slots that were not heard pick the kernel up when they next are
+  bool installed = true;
+  for (int t = 0; t < numActive; ++t)
+    installed = installed &&
+                slots[(size_t)activeSlots[(size_t)t]].isBakedKernelInstalled();
+
+  bakedSwapWaitSamples += numSamples;
+  if (!installed) {
+    bakedSwapFadeSamples = fadeSamples;
+    if (bakedSwapWaitSamples >=
+        (int)(bakedSwapTimeoutSeconds * currentSampleRate)) {
+      kernelBaker.abandonSwap();
+      bakedSwapWaitSamples = 0;
+    }
+    return;
+  }
+
+  bakedSwapFadeSamples -= numSamples;
+  if (bakedSwapFadeSamples <= 0) {
+    kernelBaker.confirmSwap();
+    bakedSwapFadeSamples = fadeSamples;
+    bakedSwapWaitSamples = 0;
+  }
+}
+
+void FreeIRAudioProcessor::setPipelinedHostedProcessing(bool shouldBeEnabled) {
+  pipelinedHostedProcessing = shouldBeEnabled;
+  updateLatency();
+}
+
+void FreeIRAudioProcessor::updateLatency() {
+  int latency = hostedGraph.getLatencySamples();
+  if (pipelinedHostedProcessing)
+    latency += hostedPipeline.getLatencySamples();
+
+  internalLatencySamples = latency;
+  setLatencySamples(latency);
+}
+
+void FreeIRAudioProcessor::processSlots(
+    const std::array<const juce::AudioBuffer<float> *, numSlots> &inputs,
+    const std::array<int, numSlots> &activeSlots, int numActive,
+    int numSamples, int engines) {
+  int numMixChannels = mixBuffer.getNumChannels();
+  double ticksToMs =
+      1000.0 / (double)juce::Time::getHighResolutionTicksPerSecond();
+  std::array<double, numSlots> costMs{};
+
+  // Per-slot tone filters all four slots at once, so when it is in use every
+  // slot renders into its own buffer (silent ones included) before the sum
+  bool toneActive = updateSlotTone();
+  if (toneActive) {
+    for (auto &out : slotOutputs) {
+      out.setSize(numMixChannels, numSamples, false, false, true);
+      out.clear();
+    }
+  }
+
+  bool parallel = shouldProcessSlotsInParallel(numActive);
+  if (parallel || toneActive) {
+    // Fork: each slot renders into its own buffer on whichever thread
+    // claims it, so nothing is shared between the tasks
+    auto task = [&](int t) {
+      auto index = (size_t)activeSlots[(size_t)t];
+      auto start = juce::Time::getHighResolutionTicks();
+
+      auto &out = slotOutputs[index];
+      out.setSize(numMixChannels, numSamples, false, false, true);
+      out.clear();
+      slots[index].process(*inputs[index], out, engines, fedEngine);
+
+      costMs[(size_t)t] =
+          (double)(juce::Time::getHighResolutionTicks() - start) * ticksToMs;
+    };
+    if (parallel) {
+      slotWorkers.run(numActive, task);
+    } else {
+      for (int t = 0; t < numActive; ++t)
+        task(t);
+    }
+
+    if (toneActive) {
+      if ((engines & IRSlot::liveEngine) != 0)
+        slotTone[0].process(slotOutputs, 0, numSamples);
+      if ((engines & IRSlot::bakedEngine) != 0 && numMixChannels == 4)
+        slotTone[1].process(slotOutputs, 2, numSamples);
+    }
+
+    // Join: reduce the per-slot buffers into the mix bus
+    for (int t = 0; t < numActive; ++t) {
+      auto &out = slotOutputs[(size_t)activeSlots[(size_t)t]];
+      for (int ch = 0; ch < numMixChannels; ++ch)
+        mixBuffer.addFrom(ch, 0, out, ch, 0, numSamples);
+    }
+  } else {
+    for (int t = 0; t < numActive; ++t) {
+      auto start = juce::Time::getHighResolutionTicks();
+      auto index = (size_t)activeSlots[(size_t)t];
+      slots[index].process(*inputs[index], mixBuffer, engines,
+                           fedEngine);
+      costMs[(size_t)t] =
+          (double)(juce::Time::getHighResolutionTicks() - start) * ticksToMs;
+    }
+  }
+
+  // Track the per-slot cost in both modes so the choice follows the load
+  if (numActive > 0) {
+    double total = 0.0;
+    for (int t = 0; t < numActive; ++t)
+      total += costMs[(size_t)t];
+    averageSlotCostMs += 0.1 * (total / numActive - averageSlotCostMs);
+  }
+}
+
+bool FreeIRAudioProcessor::updateSlotTone() {
+  for (int i = 0; i < numSlots; ++i) {
+    const auto &params = slotToneParams[(size_t)i];
+    SlotToneBank::Settings settings;
+    settings.loCutHz = params.loCut->load();
+    settings.hiCutHz = params.hiCut->load();
+    settings.tiltDb = params.tilt->load();
+
+    for (auto &bank : slotTone)
+      bank.setSlotSettings(i, settings);
+  }
+  return slotTone[0].isActive();
+}
+
+bool FreeIRAudioProcessor::shouldProcessSlotsInParallel(int numActive) const {
+  return parallelSlotProcessing && numActive > 1 &&
+         slotWorkers.getNumWorkers() > 0 &&
+         averageSlotCostMs >= minParallelSlotCostMs;
+}
+
 bool FreeIRAudioProcessor::exportMixedIR(const juce::File &outputFile) {
   // Mixes all loaded/enabled slots' raw IR data with current settings
-  // (alignment, level, pan, delay, EQ, output gain) and writes as a WAV.
+  // (alignment, level, pan, delay, slot tone, EQ, output gain) and writes
+  // as a WAV.
   // Uses raw IR buffers directly instead of the Convolution engine,
   // because JUCE's Convolution::loadImpulseResponse is asynchronous
   // and would not be ready in time for offline rendering.
 
   double sr = exportSampleRate;
 
+  // --- Snapshot the IRs so both passes see the same ones ---
+  std::array<IRAsset::Ptr, numSlots> assets;
+  for (int i = 0; i < numSlots; ++i)
+    assets[(size_t)i] = slots[i].getAsset();
+
   // --- Determine which slots contribute ---
   bool anySoloed = false;
   for (int i = 0; i < numSlots; ++i)
-    if (slots[i].isLoaded() && slots[i].isSoloed())
+    if (assets[(size_t)i] != nullptr && slots[i].isSoloed())
       anySoloed = true;
 
+  for (int i = 0; i < numSlots; ++i) {
+    bool contributes = assets[(size_t)i] != nullptr &&
+                       (anySoloed ? slots[i].isSoloed() : !slots[i].isMuted());
+    if (!contributes)
+      assets[(size_t)i] = nullptr;
+  }
+
   // --- Compute required output length from IR data + delays ---
   int maxNeeded = 0;
   for (int i = 0; i < numSlots; ++i) {
-    if (!slots[i].isLoaded())
-      continue;
-    if (anySoloed && !slots[i].isSoloed())
-      continue;
-    if (!anySoloed && slots[i].isMuted())
+    const auto &asset = assets[(size_t)i];
+    if (asset == nullptr)
       continue;
 
-    double ratio = sr / slots[i].getIRSampleRate();
+    double ratio = sr / asset->getSampleRate();
     int resampledLen =
-        (int)std::ceil(slots[i].getIRBuffer().getNumSamples() * ratio);
+        (int)std::ceil(asset->getBuffer().getNumSamples() * ratio);
 
     auto prefix = "Slot" + juce::String(i + 1) + "_";
     float userDelayMs =
@@ -239,25 +567,29 @@ bool FreeIRAudioProcessor::exportMixedIR(const juce::File &outputFile) {
   if (maxNeeded == 0)
     return false;
 
-  // Pad for EQ filter ringing (100 ms)
-  int lengthSamples = maxNeeded + (int)(sr * 0.1);
+  // Pad for EQ filter ringing
+  int lengthSamples =
+      maxNeeded + (int)(sr * EQProcessor::ringOutSeconds);
 
-  // --- Mix all active slots' raw IR data ---
+  // --- Place each active slot's raw IR data on its own bus ---
   juce::AudioBuffer<float> exportMix(2, lengthSamples);
   exportMix.clear();
 
+  std::array<juce::AudioBuffer<float>, numSlots> slotMixes;
+  for (auto &slotMix : slotMixes) {
+    slotMix.setSize(2, lengthSamples);
+    slotMix.clear();
+  }
+
   for (int i = 0; i < numSlots; ++i) {
-    if (!slots[i].isLoaded())
-      continue;
-    if (anySoloed && !slots[i].isSoloed())
-      continue;
-    if (!anySoloed && slots[i].isMuted())
+    const auto &asset = assets[(size_t)i];
+    if (asset == nullptr)
       continue;
 
-    const auto &irBuf = slots[i].getIRBuffer();
+    const auto &irBuf = asset->getBuffer();
     int irChans = irBuf.getNumChannels();
     int irLen = irBuf.getNumSamples();
-    double irSR = slots[i].getIRSampleRate();
+    double irSR = asset->getSampleRate();
     double ratio = sr / irSR;
     int resampledLen = (int)std::ceil(irLen * ratio);
 
@@ -301,22 +633,38 @@ bool FreeIRAudioProcessor::exportMixedIR(const juce::File &outputFile) {
     float gainL = std::cos(angle);
     float gainR = std::sin(angle);
 
+    // Scaled like the slot's kernel, so the balance matches what is heard
     float levelDb =
         apvts.getRawParameterValue(prefix + "Level")->load();
-    float levelGain = juce::Decibels::decibelsToGain(levelDb, -60.0f);
+    float levelGain = juce::Decibels::decibelsToGain(levelDb, -60.0f) *
+                      slots[i].getKernelGain(*asset, sr);
 
     // Add to mix with delay offset, pan, and level
     for (int j = 0; j < resampledLen; ++j) {
       int outIdx = j + delaySamples;
       if (outIdx >= lengthSamples)
         break;
-      exportMix.addSample(0, outIdx,
-                          slotIR.getSample(0, j) * gainL * levelGain);
-      exportMix.addSample(1, outIdx,
-                          slotIR.getSample(1, j) * gainR * levelGain);
+      slotMixes[i].addSample(0, outIdx,
+                             slotIR.getSample(0, j) * gainL * levelGain);
+      slotMixes[i].addSample(1, outIdx,
+                             slotIR.getSample(1, j) * gainR * levelGain);
     }
   }
 
+  // --- Per-slot tone, then the sum ---
+  SlotToneBank exportTone;
+  exportTone.prepare(sr, lengthSamples);
+  for (int i = 0; i < numSlots; ++i) {
+    const auto &params = slotToneParams[(size_t)i];
+    exportTone.setSlotSettings(
+        i, {params.loCut->load(), params.hiCut->load(), params.tilt->load()});
+  }
+  exportTone.process(slotMixes, 0, lengthSamples);
+
+  for (auto &slotMix : slotMixes)
+    for (int ch = 0; ch < 2; ++ch)
+      exportMix.addFrom(ch, 0, slotMix, ch, 0, lengthSamples);
+
   // --- Apply EQ in blocks ---
   int blockSize = 512;
   juce::dsp::ProcessSpec eqSpec;
@@ -395,7 +743,19 @@ const juce::String FreeIRAudioProcessor::getName() const {
 bool FreeIRAudioProcessor::acceptsMidi() const { return false; }
 bool FreeIRAudioProcessor::producesMidi() const { return false; }
 bool FreeIRAudioProcessor::isMidiEffect() const { return false; }
-double FreeIRAudioProcessor::getTailLengthSeconds() const { return 0.0; }
+double FreeIRAudioProcessor::getTailLengthSeconds() const {
+  // The IR bank's tail, after whatever tail the hosted graph reports
+  return hostedGraph.getTailLengthSeconds() + getIRTailSeconds();
+}
+
+double FreeIRAudioProcessor::getIRTailSeconds() const {
+  double irTail = 0.0;
+  for (const auto &slot : slots)
+    irTail = juce::jmax(irTail, slot.getIRLengthSeconds());
+  if (irTail > 0.0)
+    irTail += maxSlotDelaySeconds + EQProcessor::ringOutSeconds;
+  return irTail;
+}
 
 int FreeIRAudioProcessor::getNumPrograms() { return 1; }
 int FreeIRAudioProcessor::getCurrentProgram() { return 0; }
@@ -416,6 +776,11 @@ void FreeIRAudioProcessor::getStateInformation(juce::MemoryBlock &destData) {
   }
 
   state.setProperty("currentPresetName", currentPresetName, nullptr);
+  state.setProperty("parallelSlots", isParallelSlotProcessing(), nullptr);
+  state.setProperty("pipelinedHosted", isPipelinedHostedProcessing(),
+                    nullptr);
+  state.setProperty("bakedEQ", isBakedEQ(), nullptr);
+  state.setProperty("loudnessMatch", isLoudnessMatching(), nullptr);
 
   std::unique_ptr<juce::XmlElement> xml(state.createXml());
   copyXmlToBinary(*xml, destData);
@@ -446,6 +811,11 @@ void FreeIRAudioProcessor::setStateInformation(const void *data,
       }
 
       currentPresetName = state.getProperty("currentPresetName", "Init");
+      setParallelSlotProcessing(state.getProperty("parallelSlots", false));
+      setPipelinedHostedProcessing(
+          state.getProperty("pipelinedHosted", false));
+      setBakedEQ(state.getProperty("bakedEQ", false));
+      setLoudnessMatching(state.getProperty("loudnessMatch", false));
     }
   }
 }
@@ -466,6 +836,10 @@ void FreeIRAudioProcessor::cacheManualDelays() {
 void FreeIRAudioProcessor::applyAlignmentResults() {
   auto results = autoAligner.results;
   for (int i = 0; i < 4; ++i) {
+    // Out of the parameter's reach: keep the delay the user had
+    if (autoAligner.outOfRange[(size_t)i])
+      continue;
+
     auto *param = apvts.getParameter("Slot" + juce::String(i + 1) + "_DelayMs");
     if (param) {
       if (auto *p = dynamic_cast<juce::AudioParameterFloat *>(param)) {
@@ -493,36 +867,46 @@ void FreeIRAudioProcessor::revertAutoAlignment() {
 void FreeIRAudioProcessor::loadHostedPlugin(
     const juce::PluginDescription &desc,
     std::function<void(bool)> callback) {
+  loadHostedPluginIntoNode(hostedGraph.getOrCreatePrimaryNode(), desc,
+                           std::move(callback));
+}
+
+void FreeIRAudioProcessor::loadHostedPluginIntoNode(
+    int nodeId, const juce::PluginDescription &desc,
+    std::function<void(bool)> callback) {
 
   pluginFormatManager.createPluginInstanceAsync(
       desc, currentSampleRate, currentBlockSize,
-      [this, callback](std::unique_ptr<juce::AudioPluginInstance> instance,
-                       const juce::String &error) {
+      [this, nodeId,
+       callback](std::unique_ptr<juce::AudioPluginInstance> instance,
+                 const juce::String &error) {
         if (instance != nullptr) {
           instance->prepareToPlay(currentSampleRate, currentBlockSize);
           instance->setPlayHead(getPlayHead());
 
-          const juce::ScopedLock sl(hostedPluginLock);
-          hostedPlugin = std::move(instance);
+          // Published atomically; the old instance is torn down later,
+          // once the audio thread has faded away from it
+          hostedGraph.setNodeInstance(nodeId, std::move(instance));
         } else {
           DBG("Failed to load hosted plugin: " + error);
         }
 
         if (callback)
-          callback(instance != nullptr || hostedPlugin != nullptr);
+          callback(hostedGraph.getNodeInstance(nodeId) != nullptr);
       });
 }
 
 void FreeIRAudioProcessor::unloadHostedPlugin() {
-  const juce::ScopedLock sl(hostedPluginLock);
-  if (hostedPlugin != nullptr) {
-    hostedPlugin->releaseResources();
-    hostedPlugin.reset();
-  }
+  // The node stays in the graph; without an instance it just passes through
+  hostedGraph.setNodeInstance(hostedGraph.getPrimaryNode(), nullptr);
 }
 
 juce::String FreeIRAudioProcessor::getHostedPluginName() const {
-  if (hostedPlugin != nullptr)
-    return hostedPlugin->getName();
+  if (auto *plugin = getHostedPlugin())
+    return plugin->getName();
   return {};
 }
+
+uint32_t FreeIRAudioProcessor::getNumAudioThreadWaits() const {
+  return slotWorkers.getNumJoinWaits() + hostedPipeline.getNumWaits();
+}
@@ -1,9 +1,16 @@
 #pragma once
 
+#include "AuditionEngine.h"
 #include "AutoAligner.h"
+#include "EQKernelBaker.h"
 #include "EQProcessor.h"
+#include "HostedPluginGraph.h"
+#include "IRLoader.h"
 #include "IRSlot.h"
+#include "PipelinedStage.h"
 #include "PresetManager.h"
+#include "RealtimeWorkerPool.h"
+#include "SlotToneBank.h"
 #include <JuceHeader.h>
 
 //==============================================================================
@@ -52,8 +59,14 @@ public:
   const IRSlot &getIRSlot(int index) const { return slots[(size_t)index]; }
   EQProcessor &getEQ() { return eqProcessor; }
   AutoAligner &getAutoAligner() { return autoAligner; }
+
+  // Broadcasts a change whenever a slot's IR finishes loading
+  IRLoader &getIRLoader() { return irLoader; }
   PresetManager &getPresetManager() { return presetManager; }
 
+  // Plays the browser's selection through an armed slot
+  AuditionEngine &getAudition() { return audition; }
+
   static constexpr int numSlots = 4;
 
   // Export mixed IR to a WAV file
@@ -65,6 +78,35 @@ public:
 
   juce::String currentPresetName = "Init";
 
+  // Performance: run active slots on realtime worker threads when the
+  // per-slot cost is high enough to outweigh the fork-join overhead
+  void setParallelSlotProcessing(bool shouldBeEnabled) {
+    parallelSlotProcessing = shouldBeEnabled;
+  }
+  bool isParallelSlotProcessing() const { return parallelSlotProcessing; }
+
+  // Performance: run the hosted plugin one block ahead on its own thread,
+  // overlapping it with the IR bank. Adds one block of reported latency.
+  void setPipelinedHostedProcessing(bool shouldBeEnabled);
+  bool isPipelinedHostedProcessing() const {
+    return pipelinedHostedProcessing;
+  }
+
+  // Performance: while the EQ sits still, render it into the slot kernels
+  // on a background thread and skip the live EQ filters. The live
+  // convolution keeps running underneath, so a knob move hands back at once.
+  void setBakedEQ(bool shouldBeEnabled) {
+    kernelBaker.setEnabled(shouldBeEnabled);
+  }
+  bool isBakedEQ() const { return kernelBaker.isEnabled(); }
+
+  // Loading: match every IR's K-weighted loudness, folded into the kernels
+  void setLoudnessMatching(bool shouldMatch) {
+    for (auto &slot : slots)
+      slot.setLoudnessMatching(shouldMatch);
+  }
+  bool isLoudnessMatching() const { return slots[0].isLoudnessMatching(); }
+
   // Auto Align Helpers
   void cacheManualDelays();
   void applyAlignmentResults();
@@ -76,34 +118,123 @@ public:
   }
   juce::KnownPluginList &getKnownPluginList() { return knownPluginList; }
 
+  // The header "Load Plugin" button targets the primary node of the graph
   void loadHostedPlugin(const juce::PluginDescription &desc,
                         std::function<void(bool)> callback);
   void unloadHostedPlugin();
   juce::AudioPluginInstance *getHostedPlugin() const {
-    return hostedPlugin.get();
+    return hostedGraph.getNodeInstance(hostedGraph.getPrimaryNode());
   }
   juce::String getHostedPluginName() const;
-  bool hasHostedPlugin() const { return hostedPlugin != nullptr; }
+  bool hasHostedPlugin() const { return getHostedPlugin() != nullptr; }
+
+  // Pre/post chains and parallel branches of hosted plugins
+  HostedPluginGraph &getHostedGraph() { return hostedGraph; }
+  void loadHostedPluginIntoNode(int nodeId, const juce::PluginDescription &desc,
+                                std::function<void(bool)> callback);
+
+  // Times the audio thread had to wait on a worker (pool join / pipeline)
+  uint32_t getNumAudioThreadWaits() const;
 
 private:
   juce::AudioProcessorValueTreeState apvts;
   juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
 
   std::array<IRSlot, numSlots> slots;
+  IRLoader irLoader{slots}; // Declared after the slots it writes to
+  AuditionEngine audition{slots, irLoader};
   EQProcessor eqProcessor;
   AutoAligner autoAligner;
   PresetManager presetManager;
 
   juce::AudioBuffer<float> mixBuffer;
 
+  // --- Parallel slot processing ---
+  RealtimeWorkerPool slotWorkers{"FreeIR Slot Worker"};
+  std::array<juce::AudioBuffer<float>, numSlots> slotOutputs;
+  std::atomic<bool> parallelSlotProcessing{false};
+  double averageSlotCostMs = 0.0; // audio thread only
+
+  // Below this per-slot cost the wake-up/join overhead eats the gain
+  static constexpr double minParallelSlotCostMs = 0.05;
+
+  void processSlots(
+      const std::array<const juce::AudioBuffer<float> *, numSlots> &inputs,
+      const std::array<int, numSlots> &activeSlots, int numActive,
+      int numSamples, int engines);
+  bool shouldProcessSlotsInParallel(int numActive) const;
+
+  // --- Per-slot tone ---
+  // One bank per engine pair (live 0/1, baked 2/3) so each keeps its own
+  // filter state across a handover
+  std::array<SlotToneBank, 2> slotTone;
+
+  struct SlotToneParams {
+    std::atomic<float> *loCut = nullptr, *hiCut = nullptr, *tilt = nullptr;
+  };
+  std::array<SlotToneParams, numSlots> slotToneParams;
+
+  // Audio thread: pushes the slot tone parameters; true if any slot is shaped
+  bool updateSlotTone();
+
+  // --- Baked EQ ---
+  // The mix bus carries the live pair (0/1, EQ still to apply) and the baked
+  // pair (2/3). Only one pair is fed the input. On a handover the input
+  // moves at once and the pair it leaves runs on silence until its tail has
+  // rung out, so the two add up to one response with nothing to warm up or
+  // crossfade; otherwise only the fed pair runs (and its EQ or tone). The
+  // baked pair also runs while a new bake waits to be swapped in.
+  EQKernelBaker kernelBaker{slots, apvts};
+  int fedEngine = IRSlot::liveEngine;      // audio thread only
+  int runningEngines = IRSlot::liveEngine; // audio thread only
+  int liveRingOutSamples = 0;              // audio thread only
+  int bakedRingOutSamples = 0;             // audio thread only
+
+  // A bake is heard once every active slot's convolver has picked it up
+  // and finished its own crossfade onto it; one that has not shown up after
+  // the timeout (the engines were rebuilt meanwhile) is baked again
+  int bakedSwapFadeSamples = 0; // audio thread only
+  int bakedSwapWaitSamples = 0; // audio thread only
+  static constexpr double convolverFadeSeconds = 0.05;
+  static constexpr double bakedSwapTimeoutSeconds = 1.0;
+
+  int selectSlotEngines(int numSamples);
+  void updateBakedSwap(const std::array<int, numSlots> &activeSlots,
+                       int numActive, int numSamples);
+
+  // Longest IR plus the widest slot delay and the EQ ringing, or 0
+  double getIRTailSeconds() const;
+
+  // --- Pipelined hosted plugin ---
+  PipelinedStage hostedPipeline{"FreeIR Hosted Plugin"};
+  std::atomic<bool> pipelinedHostedProcessing{false};
+  bool pipelineActive = false; // audio thread only
+
+  void updateLatency();
+
+  // --- Latency-compensated dry path ---
+  // The input is delayed by the internal latency (hosted graph + pipeline)
+  // so blending it back in stays phase-aligned with the wet signal.
+  juce::dsp::DelayLine<float, juce::dsp::DelayLineInterpolationTypes::None>
+      dryDelay;
+  juce::AudioBuffer<float> dryBuffer;
+  juce::SmoothedValue<float> dryMix;
+  std::atomic<float> *dryMixParam = nullptr;
+  std::atomic<int> internalLatencySamples{0};
+  bool dryPathRunning = false; // audio thread only
+
+  // A slot's delay: the DelayMs parameter plus the aligner's offset
+  static constexpr double maxSlotDelaySeconds =
+      (IRSlot::maxUserDelayMs + AutoAligner::maxDelayMs) / 1000.0;
+
   double currentSampleRate = 48000.0;
   int currentBlockSize = 512;
 
   // --- Hosted Plugin ---
   juce::AudioPluginFormatManager pluginFormatManager;
   juce::KnownPluginList knownPluginList;
-  std::unique_ptr<juce::AudioPluginInstance> hostedPlugin;
-  juce::CriticalSection hostedPluginLock;
+  HostedPluginGraph hostedGraph;
+  static_assert(HostedPluginGraph::numSlots == numSlots);
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(FreeIRAudioProcessor)
 };
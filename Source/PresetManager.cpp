@@ -1,9 +1,13 @@
 #include "PresetManager.h"
 
-PresetManager::PresetManager() {
+juce::File PresetManager::getDefaultRootFolder() {
   auto appData =
       juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory);
-  rootFolder = appData.getChildFile("CohenConcepts").getChildFile("FreeIR");
+  return appData.getChildFile("CohenConcepts").getChildFile("FreeIR");
+}
+
+PresetManager::PresetManager() {
+  rootFolder = getDefaultRootFolder();
   presetsFolder = rootFolder.getChildFile("Presets");
   settingsFile = rootFolder.getChildFile("settings.xml");
 
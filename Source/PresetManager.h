@@ -31,6 +31,12 @@ public:
 
   juce::File getPresetsFolder() const;
 
+  // Per-user data folder that also holds settings.xml
+  juce::File getRootFolder() const { return rootFolder; }
+
+  // Same folder, for shared objects that have no PresetManager at hand
+  static juce::File getDefaultRootFolder();
+
 private:
   juce::File rootFolder;
   juce::File presetsFolder;
@@ -0,0 +1,164 @@
+#include "RealtimeWorkerPool.h"
+
+#if JUCE_WINDOWS
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif JUCE_MAC || JUCE_IOS
+#include <dispatch/dispatch.h>
+#else
+#include <cerrno>
+#include <semaphore.h>
+#endif
+
+RealtimeWorkerPool::RealtimeWorkerPool(const juce::String &threadName)
+    : name(threadName) {}
+
+RealtimeWorkerPool::~RealtimeWorkerPool() { stop(); }
+
+void RealtimeWorkerPool::start(int numWorkers) {
+  stop();
+
+  for (int i = 0; i < numWorkers; ++i) {
+    auto *worker =
+        workers.add(new Worker(*this, name + " " + juce::String(i + 1)));
+
+    // Fall back to a normal thread if the OS refuses realtime scheduling
+    if (!worker->startRealtimeThread(
+            juce::Thread::RealtimeOptions{}.withPriority(10)))
+      worker->startThread();
+  }
+}
+
+void RealtimeWorkerPool::stop() {
+  for (auto *worker : workers)
+    worker->signalThreadShouldExit();
+
+  for (auto *worker : workers) {
+    worker->wake();
+    worker->stopThread(1000);
+  }
+
+  workers.clear();
+}
+
+void RealtimeWorkerPool::runTasks(int numTasks, TaskFn fn, void *context) {
+  jassert(numTasks <= maxTasks);
+
+  if (numTasks <= 0)
+    return;
+
+  // Nothing to share -- run inline and skip the synchronisation entirely
+  if (workers.isEmpty() || numTasks == 1) {
+    for (int i = 0; i < numTasks; ++i)
+      fn(context, i);
+    return;
+  }
+
+  taskFn = fn;
+  taskContext = context;
+  pendingTasks.store(numTasks, std::memory_order_relaxed);
+
+  auto batch = stateBatch(state.load(std::memory_order_relaxed)) + 1;
+  state.store(packState(batch, numTasks, 0), std::memory_order_release);
+
+  // The caller takes one task itself, so only wake as many as can help
+  int numToWake = juce::jmin(workers.size(), numTasks - 1);
+  for (int i = 0; i < numToWake; ++i)
+    workers.getUnchecked(i)->wake();
+
+  helpWithTasks();
+
+  // Only tasks already claimed by a worker can still be running here
+  if (pendingTasks.load(std::memory_order_acquire) > 0) {
+    joinWaits.fetch_add(1, std::memory_order_relaxed);
+    while (pendingTasks.load(std::memory_order_acquire) > 0)
+      juce::Thread::yield();
+  }
+}
+
+void RealtimeWorkerPool::helpWithTasks() {
+  auto s = state.load(std::memory_order_acquire);
+
+  for (;;) {
+    int next = stateNext(s);
+    if (next >= stateCount(s))
+      return;
+
+    if (state.compare_exchange_weak(s, s + 1, std::memory_order_acq_rel,
+                                    std::memory_order_acquire)) {
+      taskFn(taskContext, next);
+      pendingTasks.fetch_sub(1, std::memory_order_release);
+      s = state.load(std::memory_order_acquire);
+    }
+  }
+}
+
+//==============================================================================
+struct RealtimeWorkerPool::WakeSignal::Native {
+#if JUCE_WINDOWS
+  Native() : handle(CreateSemaphoreW(nullptr, 0, LONG_MAX, nullptr)) {}
+  ~Native() { CloseHandle(handle); }
+  void post() { ReleaseSemaphore(handle, 1, nullptr); }
+  void wait() { WaitForSingleObject(handle, INFINITE); }
+  HANDLE handle;
+#elif JUCE_MAC || JUCE_IOS
+  Native() : semaphore(dispatch_semaphore_create(0)) {}
+  ~Native() { dispatch_release(semaphore); }
+  void post() { dispatch_semaphore_signal(semaphore); }
+  void wait() { dispatch_semaphore_wait(semaphore, DISPATCH_TIME_FOREVER); }
+  dispatch_semaphore_t semaphore;
+#else
+  Native() { sem_init(&semaphore, 0, 0); }
+  ~Native() { sem_destroy(&semaphore); }
+  void post() { sem_post(&semaphore); }
+  void wait() {
+    while (sem_wait(&semaphore) != 0 && errno == EINTR) {
+    }
+  }
+  sem_t semaphore;
+#endif
+};
+
+RealtimeWorkerPool::WakeSignal::WakeSignal()
+    : native(std::make_unique<Native>()) {}
+
+RealtimeWorkerPool::WakeSignal::~WakeSignal() = default;
+
+void RealtimeWorkerPool::WakeSignal::signal() {
+  if (count.fetch_add(1, std::memory_order_release) < 0)
+    native->post();
+}
+
+void RealtimeWorkerPool::WakeSignal::wait() {
+  // Batches often follow each other within one block, so spin a little
+  // before paying for a park and a kernel wake
+  for (int i = 0; i < spinCount; ++i) {
+    auto c = count.load(std::memory_order_relaxed);
+    if (c > 0 && count.compare_exchange_weak(c, c - 1,
+                                             std::memory_order_acquire,
+                                             std::memory_order_relaxed))
+      return;
+  }
+
+  if (count.fetch_sub(1, std::memory_order_acquire) <= 0)
+    native->wait();
+}
+
+//==============================================================================
+RealtimeWorkerPool::Worker::Worker(RealtimeWorkerPool &owner,
+                                   const juce::String &threadName)
+    : juce::Thread(threadName), pool(owner) {}
+
+void RealtimeWorkerPool::Worker::run() {
+  // Denormal flags are per-thread, so set them here as processBlock does
+  juce::ScopedNoDenormals noDenormals;
+
+  // stop() wakes every worker after flagging it, so the wait needs no
+  // timeout to notice an exit
+  while (!threadShouldExit()) {
+    wakeSignal.wait();
+    pool.helpWithTasks();
+  }
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+//==============================================================================
+// RealtimeWorkerPool: a few realtime threads that help the audio thread run a
+// batch of independent tasks inside a single processBlock call (fork-join).
+// The calling thread claims tasks too, so a late worker wake-up never stalls
+// the block -- the caller just ends up running more of the tasks itself.
+//==============================================================================
+class RealtimeWorkerPool {
+public:
+  explicit RealtimeWorkerPool(const juce::String &threadName);
+  ~RealtimeWorkerPool();
+
+  // (Re)starts the worker threads. Call while audio is stopped
+  // (prepareToPlay / releaseResources), never from the audio thread.
+  void start(int numWorkers);
+  void stop();
+
+  int getNumWorkers() const { return workers.size(); }
+
+  // Runs fn(0) ... fn(numTasks - 1) across the caller and the workers and
+  // returns once all of them have finished. Not re-entrant; no allocation.
+  template <typename Fn> void run(int numTasks, Fn &fn) {
+    runTasks(numTasks, &RealtimeWorkerPool::invoke<Fn>, &fn);
+  }
+
+  // Number of times run() had to wait for a worker to finish its task
+  uint32_t getNumJoinWaits() const { return joinWaits.load(); }
+
+  static constexpr int maxTasks = 255;
+
+private:
+  using TaskFn = void (*)(void *context, int taskIndex);
+
+  template <typename Fn> static void invoke(void *context, int taskIndex) {
+    (*static_cast<Fn *>(context))(taskIndex);
+  }
+
+  void runTasks(int numTasks, TaskFn fn, void *context);
+
+  // Claims and runs tasks of the current batch until none are left
+  void helpWithTasks();
+
+  // Counting semaphore the audio thread can post without taking a lock.
+  // The count is an atomic; the OS semaphore is only posted when a worker
+  // has parked on it, and posting one is a bare syscall on every platform.
+  // A waiter spins for a while before it parks.
+  class WakeSignal {
+  public:
+    WakeSignal();
+    ~WakeSignal();
+
+    void signal();
+    void wait();
+
+  private:
+    struct Native;
+    std::unique_ptr<Native> native;
+    std::atomic<int> count{0}; // Negative: a waiter is parked
+
+    static constexpr int spinCount = 1024;
+
+    JUCE_DECLARE_NON_COPYABLE(WakeSignal)
+  };
+
+  class Worker : public juce::Thread {
+  public:
+    Worker(RealtimeWorkerPool &owner, const juce::String &name);
+    void run() override;
+    void wake() { wakeSignal.signal(); }
+
+  private:
+    RealtimeWorkerPool &pool;
+    WakeSignal wakeSignal;
+  };
+
+  // Batch state packed into one word so a claim is a single CAS:
+  // [ batch id : 24 | task count : 8 | next task index : 32 ]
+  static uint64_t packState(uint32_t batch, int count, int next) {
+    return ((uint64_t)(batch & 0xffffffu) << 40) |
+           ((uint64_t)(count & 0xff) << 32) | (uint64_t)(uint32_t)next;
+  }
+  static int stateCount(uint64_t s) { return (int)((s >> 32) & 0xff); }
+  static int stateNext(uint64_t s) { return (int)(uint32_t)s; }
+  static uint32_t stateBatch(uint64_t s) { return (uint32_t)(s >> 40); }
+
+  juce::String name;
+  juce::OwnedArray<Worker> workers;
+
+  std::atomic<uint64_t> state{0};
+  std::atomic<int> pendingTasks{0};
+  std::atomic<uint32_t> joinWaits{0};
+  TaskFn taskFn = nullptr;
+  void *taskContext = nullptr;
+
+  JUCE_DECLARE_NON_COPYABLE(RealtimeWorkerPool)
+};
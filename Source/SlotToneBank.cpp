@@ -0,0 +1,216 @@
+#include "SlotToneBank.h"
+
+void SlotToneBank::prepare(double newSampleRate, int maxBlockSize) {
+  sampleRate = newSampleRate;
+  work.resize((size_t)(2 * juce::jmax(1, maxBlockSize)));
+
+  for (auto &glide : glides) {
+    glide.loCutHz.reset(sampleRate, smoothingSeconds);
+    glide.hiCutHz.reset(sampleRate, smoothingSeconds);
+    glide.tiltDb.reset(sampleRate, smoothingSeconds);
+  }
+  reset();
+}
+
+void SlotToneBank::reset() {
+  for (auto &section : sections) {
+    section.s1.fill(Register(0.0f));
+    section.s2.fill(Register(0.0f));
+  }
+
+  // A restarted bank has nothing to glide from
+  for (int slot = 0; slot < numSlots; ++slot) {
+    glides[(size_t)slot].started = false;
+    jumpToTargets(slot);
+  }
+  compile();
+}
+
+void SlotToneBank::setSlotSettings(int slot, const Settings &newSettings) {
+  auto &glide = glides[(size_t)slot];
+  if (glide.started && settings[(size_t)slot] == newSettings)
+    return;
+
+  settings[(size_t)slot] = newSettings;
+  if (!glide.started) {
+    glide.started = true;
+    jumpToTargets(slot);
+    compile();
+    return;
+  }
+
+  float maxHz = (float)(sampleRate * 0.49);
+  glide.loCutHz.setTargetValue(juce::jmin(newSettings.loCutHz, maxHz));
+  glide.hiCutHz.setTargetValue(juce::jmin(newSettings.hiCutHz, maxHz));
+  glide.tiltDb.setTargetValue(newSettings.tiltDb);
+
+  // A section leaving "off" joins the cascade before it starts to move
+  updateSlot(slot);
+  compile();
+}
+
+bool SlotToneBank::isSmoothing() const {
+  return std::any_of(glides.begin(), glides.end(),
+                     [](const Glide &g) { return g.isSmoothing(); });
+}
+
+void SlotToneBank::jumpToTargets(int slot) {
+  const auto &s = settings[(size_t)slot];
+  auto &glide = glides[(size_t)slot];
+  float maxHz = (float)(sampleRate * 0.49);
+
+  glide.loCutHz.setCurrentAndTargetValue(juce::jmin(s.loCutHz, maxHz));
+  glide.hiCutHz.setCurrentAndTargetValue(juce::jmin(s.hiCutHz, maxHz));
+  glide.tiltDb.setCurrentAndTargetValue(s.tiltDb);
+  updateSlot(slot);
+}
+
+void SlotToneBank::advanceSmoothing(int numSamples) {
+  // Only the slots that are gliding get new coefficients
+  bool moved = false;
+  for (int slot = 0; slot < numSlots; ++slot) {
+    auto &glide = glides[(size_t)slot];
+    if (!glide.isSmoothing())
+      continue;
+
+    glide.loCutHz.skip(numSamples);
+    glide.hiCutHz.skip(numSamples);
+    glide.tiltDb.skip(numSamples);
+    updateSlot(slot);
+    moved = true;
+  }
+
+  if (moved)
+    compile();
+}
+
+void SlotToneBank::updateSlot(int slot) {
+  const auto &s = settings[(size_t)slot];
+  const auto &glide = glides[(size_t)slot];
+
+  // A cut is off only once it has come to rest at its end of the range
+  bool loCutFlat = s.loCutHz <= minLoCutHz && !glide.loCutHz.isSmoothing();
+  setLanes(sections[loCut], slot,
+           loCutFlat ? EQProcessor::Biquad{}
+                     : EQProcessor::makeHighPass(
+                           sampleRate, glide.loCutHz.getCurrentValue()),
+           loCutFlat);
+
+  // Low shelf cut by the full tilt, then lifted by half of it overall
+  float tiltDb = glide.tiltDb.getCurrentValue();
+  bool tiltFlat = std::abs(tiltDb) < 0.01f && !glide.tiltDb.isSmoothing();
+  auto t = EQProcessor::makeLowShelf(sampleRate, tiltPivotHz, 0.5f, -tiltDb);
+  float lift = juce::Decibels::decibelsToGain(tiltDb * 0.5f);
+  t.b0 *= lift;
+  t.b1 *= lift;
+  t.b2 *= lift;
+  setLanes(sections[tilt], slot, tiltFlat ? EQProcessor::Biquad{} : t,
+           tiltFlat);
+
+  bool hiCutFlat = s.hiCutHz >= maxHiCutHz && !glide.hiCutHz.isSmoothing();
+  setLanes(sections[hiCut], slot,
+           hiCutFlat ? EQProcessor::Biquad{}
+                     : EQProcessor::makeLowPass(
+                           sampleRate, glide.hiCutHz.getCurrentValue()),
+           hiCutFlat);
+}
+
+void SlotToneBank::setLanes(Section &section, int slot,
+                            const EQProcessor::Biquad &c, bool flat) {
+  // Slot n owns lanes 2n (L) and 2n + 1 (R)
+  auto reg = (size_t)(slot / 2);
+  auto lane = (size_t)((slot % 2) * 2);
+
+  for (size_t ch = 0; ch < 2; ++ch) {
+    section.b0[reg].set(lane + ch, c.b0);
+    section.b1[reg].set(lane + ch, c.b1);
+    section.b2[reg].set(lane + ch, c.b2);
+    section.a1[reg].set(lane + ch, c.a1);
+    section.a2[reg].set(lane + ch, c.a2);
+
+    // Lanes start from rest whenever they enter or leave the bypass, so
+    // a stale state neither leaks into a passthrough lane nor re-enters
+    if (section.flat[(size_t)slot] != flat) {
+      section.s1[reg].set(lane + ch, 0.0f);
+      section.s2[reg].set(lane + ch, 0.0f);
+    }
+  }
+  section.flat[(size_t)slot] = flat;
+}
+
+void SlotToneBank::compile() {
+  numActiveSections = 0;
+  for (int stage = 0; stage < numStages; ++stage) {
+    auto &flat = sections[(size_t)stage].flat;
+    bool allFlat = std::all_of(flat.begin(), flat.end(),
+                               [](bool f) { return f; });
+    if (!allFlat)
+      activeSections[(size_t)numActiveSections++] = stage;
+  }
+}
+
+//==============================================================================
+void SlotToneBank::process(
+    std::array<juce::AudioBuffer<float>, numSlots> &slotBuffers,
+    int firstChannel, int numSamples) {
+  int chunkSize = (int)work.size() / 2;
+
+  // Whole chunks when settled; short sub-blocks while a slot glides
+  for (int pos = 0; pos < numSamples;) {
+    int n = juce::jmin(chunkSize, numSamples - pos);
+    if (isSmoothing()) {
+      n = juce::jmin(n, subBlockSize);
+      advanceSmoothing(n);
+    }
+
+    if (numActiveSections > 0)
+      processChunk(slotBuffers, firstChannel, pos, n);
+    pos += n;
+  }
+}
+
+void SlotToneBank::processChunk(
+    std::array<juce::AudioBuffer<float>, numSlots> &slotBuffers,
+    int firstChannel, int start, int numSamples) {
+  auto *lanes = reinterpret_cast<float *>(work.data());
+
+  // Sample i occupies floats [8i, 8i + 8): slot-major, L then R
+  for (int slot = 0; slot < numSlots; ++slot) {
+    for (int ch = 0; ch < 2; ++ch) {
+      const float *in =
+          slotBuffers[(size_t)slot].getReadPointer(firstChannel + ch, start);
+      for (int i = 0; i < numSamples; ++i)
+        lanes[8 * i + 2 * slot + ch] = in[i];
+    }
+  }
+
+  for (int k = 0; k < numActiveSections; ++k) {
+    auto &sec = sections[(size_t)activeSections[(size_t)k]];
+
+    for (size_t r = 0; r < 2; ++r) {
+      Register b0 = sec.b0[r], b1 = sec.b1[r], b2 = sec.b2[r];
+      Register a1 = sec.a1[r], a2 = sec.a2[r];
+      Register s1 = sec.s1[r], s2 = sec.s2[r];
+
+      for (int i = 0; i < numSamples; ++i) {
+        Register &x = work[(size_t)(2 * i) + r];
+        Register out = b0 * x + s1;
+        s1 = b1 * x - a1 * out + s2;
+        s2 = b2 * x - a2 * out;
+        x = out;
+      }
+
+      sec.s1[r] = s1;
+      sec.s2[r] = s2;
+    }
+  }
+
+  for (int slot = 0; slot < numSlots; ++slot) {
+    for (int ch = 0; ch < 2; ++ch) {
+      float *out =
+          slotBuffers[(size_t)slot].getWritePointer(firstChannel + ch, start);
+      for (int i = 0; i < numSamples; ++i)
+        out[i] = lanes[8 * i + 2 * slot + ch];
+    }
+  }
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include "EQProcessor.h"
+#include <JuceHeader.h>
+
+//==============================================================================
+// SlotToneBank: per-slot lo-cut, hi-cut and tilt for all four slots at once.
+//
+// The 4 slots x 2 channels form 8 lanes held in two SIMD registers, so the
+// whole bank runs as one three-section biquad cascade per sample instead of
+// eight scalar chains. Each lane gets its slot's own coefficients; a section
+// that is flat on every lane is skipped.
+//
+// Like EQProcessor, parameter changes glide over smoothingSeconds and the
+// moving slots' coefficients are recomputed every subBlockSize samples.
+//==============================================================================
+class SlotToneBank {
+public:
+  static constexpr int numSlots = 4;
+
+  // Parameter ends that mean "off"
+  static constexpr float minLoCutHz = 20.0f;
+  static constexpr float maxHiCutHz = 20000.0f;
+
+  struct Settings {
+    float loCutHz = minLoCutHz;
+    float hiCutHz = maxHiCutHz;
+    float tiltDb = 0.0f;
+
+    bool operator==(const Settings &o) const {
+      return loCutHz == o.loCutHz && hiCutHz == o.hiCutHz &&
+             tiltDb == o.tiltDb;
+    }
+    bool operator!=(const Settings &o) const { return !(*this == o); }
+  };
+
+  void prepare(double sampleRate, int maxBlockSize);
+  void reset();
+
+  // Audio thread, once per block; the first call after prepare() or reset()
+  // takes effect at once, later changes glide in
+  void setSlotSettings(int slot, const Settings &settings);
+
+  // False when every slot is flat, so the caller can skip the bank
+  bool isActive() const { return numActiveSections > 0; }
+
+  // True while a slot's change is still gliding in
+  bool isSmoothing() const;
+
+  // Filters channels [firstChannel, firstChannel + 1] of each slot buffer
+  void process(std::array<juce::AudioBuffer<float>, numSlots> &slotBuffers,
+               int firstChannel, int numSamples);
+
+private:
+  using Register = juce::dsp::SIMDRegister<float>;
+  static_assert(Register::SIMDNumElements == 4,
+                "Lane layout assumes four floats per register");
+
+  enum Stage { loCut, tilt, hiCut, numStages };
+
+  // Two registers cover lanes 0-3 (slots 1-2) and 4-7 (slots 3-4)
+  struct Section {
+    std::array<Register, 2> b0, b1, b2, a1, a2, s1, s2;
+    std::array<bool, numSlots> flat{};
+  };
+
+  // Smoothed settings of one slot: frequencies glide multiplicatively
+  using FreqSmoother =
+      juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative>;
+  struct Glide {
+    FreqSmoother loCutHz, hiCutHz;
+    juce::SmoothedValue<float> tiltDb;
+    bool started = false;
+
+    bool isSmoothing() const {
+      return loCutHz.isSmoothing() || hiCutHz.isSmoothing() ||
+             tiltDb.isSmoothing();
+    }
+  };
+
+  void processChunk(std::array<juce::AudioBuffer<float>, numSlots> &buffers,
+                    int firstChannel, int start, int numSamples);
+  void advanceSmoothing(int numSamples);
+  void jumpToTargets(int slot);
+  void updateSlot(int slot);
+  void setLanes(Section &section, int slot, const EQProcessor::Biquad &c,
+                bool flat);
+  void compile();
+
+  double sampleRate = 48000.0;
+  std::array<Section, numStages> sections;
+  std::array<Settings, numSlots> settings; // Targets
+  std::array<Glide, numSlots> glides;
+  std::array<int, numStages> activeSections{};
+  int numActiveSections = 0;
+
+  // Interleaved lanes: two registers per sample
+  std::vector<Register> work;
+
+  // Pivot of the tilt: below it goes down by half the tilt, above it up
+  static constexpr float tiltPivotHz = 800.0f;
+
+  // Same glide as the master EQ
+  static constexpr int subBlockSize = 32;
+  static constexpr double smoothingSeconds = 0.02;
+};